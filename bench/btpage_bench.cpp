@@ -0,0 +1,176 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <memory>
+#include <optional>
+
+#include "types.h"
+#include "utils.h"
+#include "core.h"
+#include "NDB.h"
+
+/**
+ * Compares NBT lookups per second of BTPage::get against the linear scan with backtracking
+ * it replaced and against the flattened NBTIndex. The tree is built in memory so only the
+ * search itself is measured.
+*/
+namespace btpage_bench
+{
+    using namespace storyt::types;
+    using namespace storyt::core;
+    using namespace storyt::ndb;
+
+    std::vector<byte_t> makeNBTPage(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& ibs, uint8_t cLevel)
+    {
+        const uint8_t entrySize = cLevel == 0 ? 0x20 : 0x18;
+        std::vector<byte_t> page(BTPage::size, 0);
+        auto write = [&page](size_t offset, uint64_t value, size_t size) {
+            for (size_t i = 0; i < size; ++i)
+            {
+                page[offset + i] = static_cast<byte_t>(value >> (8 * i));
+            }
+        };
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            const size_t offset = i * entrySize;
+            write(offset, keys[i], 8);
+            write(offset + 8, cLevel == 0 ? keys[i] + 1 : ibs[i], 8);
+            write(offset + 16, cLevel == 0 ? 0 : ibs[i], 8);
+        }
+        page[488] = static_cast<byte_t>(keys.size());
+        page[489] = static_cast<byte_t>(488 / entrySize);
+        page[490] = entrySize;
+        page[491] = cLevel;
+        page[496] = 0x81; // ptypeNBT
+        page[497] = 0x81;
+        return page;
+    }
+
+    struct Tree
+    {
+        std::unordered_map<uint64_t, std::shared_ptr<const BTPage>> pages{};
+        std::shared_ptr<const BTPage> root{};
+        std::vector<uint32_t> nids{};
+        uint64_t nextIb{ 0 };
+
+        /// Builds a page of the given level and returns {first key, ib}
+        std::pair<uint64_t, uint64_t> build(uint8_t cLevel, size_t fanout, size_t leafSize)
+        {
+            std::vector<uint64_t> keys{};
+            std::vector<uint64_t> ibs{};
+            if (cLevel == 0)
+            {
+                for (size_t i = 0; i < leafSize; ++i)
+                {
+                    const uint32_t nid = static_cast<uint32_t>((nids.size() + 1) * 0x20);
+                    nids.push_back(nid);
+                    keys.push_back(nid);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < fanout; ++i)
+                {
+                    const auto [key, ib] = build(cLevel - 1, fanout, leafSize);
+                    keys.push_back(key);
+                    ibs.push_back(ib);
+                }
+            }
+            const uint64_t ib = nextIb++;
+            pages[ib] = std::make_shared<const BTPage>(BTPage::Init(makeNBTPage(keys, ibs, cLevel)));
+            return { keys.front(), ib };
+        }
+    };
+
+    /// The lookup BTPage::get used before it switched to binary search.
+    std::optional<NBTEntry> linearGet(const BTPage& page, NID id, const BTPage::GetPage_t& getPage)
+    {
+        if (page.hasNBTEntries())
+        {
+            for (const auto& entry : page.rgentries)
+            {
+                if (entry.getCachedNBTNID() == id)
+                {
+                    return entry.asNBTEntry();
+                }
+            }
+        }
+        else if (page.hasBTEntries())
+        {
+            for (const auto& entry : page.rgentries)
+            {
+                const uint64_t btkey = entry.getCachedBTKey();
+                if (id > btkey || id == btkey)
+                {
+                    std::optional<NBTEntry> ret = linearGet(*getPage(entry.asBTEntry().bref, page.cLevel), id, getPage);
+                    if (ret.has_value())
+                    {
+                        return ret;
+                    }
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    template<typename Lookup>
+    double lookupsPerSecond(const std::vector<uint32_t>& queries, Lookup lookup, uint64_t& checksum)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (const uint32_t nid : queries)
+        {
+            const std::optional<NBTEntry> nbt = lookup(NID(nid));
+            checksum += nbt.has_value() ? nbt->bidData.getBidRaw() : 0;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(queries.size()) / elapsed.count();
+    }
+}
+
+int main()
+{
+    using namespace btpage_bench;
+
+    // 3 levels: 20 * 20 leaves of 15 NBT entries each = 6000 nodes
+    Tree tree{};
+    const auto [rootKey, rootIb] = tree.build(2, 20, 15);
+    tree.root = tree.pages.at(rootIb);
+
+    const BTPage::GetPage_t getPage = [&tree](const BREF& bref, int32_t) { return tree.pages.at(bref.ib); };
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, tree.nids.size() - 1);
+    std::vector<uint32_t> queries(200000);
+    for (auto& q : queries)
+    {
+        q = tree.nids[pick(rng)];
+    }
+
+    const NBTIndex index = NBTIndex::Init(*tree.root, getPage);
+
+    uint64_t checksumBefore{ 0 };
+    uint64_t checksumAfter{ 0 };
+    uint64_t checksumFlat{ 0 };
+    const double before = lookupsPerSecond(queries,
+        [&](NID nid) { return linearGet(*tree.root, nid, getPage); }, checksumBefore);
+    const double after = lookupsPerSecond(queries,
+        [&](NID nid) { return tree.root->get<NBTEntry>(nid, getPage); }, checksumAfter);
+    const double flat = lookupsPerSecond(queries,
+        [&](NID nid) { return index.get(nid); }, checksumFlat);
+
+    size_t treeBytes{ 0 };
+    for (const auto& [ib, page] : tree.pages)
+    {
+        treeBytes += page->nBytesInMemory();
+    }
+
+    std::cout << "nodes:                         " << tree.nids.size() << "\n";
+    std::cout << "linear scan + backtracking:    " << static_cast<uint64_t>(before) << " lookups/s\n";
+    std::cout << "binary search, single descent: " << static_cast<uint64_t>(after) << " lookups/s\n";
+    std::cout << "flattened NBTIndex:            " << static_cast<uint64_t>(flat) << " lookups/s\n";
+    std::cout << "speedup:                       " << after / before << "x (tree) " << flat / before << "x (flat)\n";
+    std::cout << "footprint:                     " << treeBytes << " bytes (tree) " << index.nBytesInMemory() << " bytes (flat)\n";
+    return (checksumBefore == checksumAfter && checksumAfter == checksumFlat) ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "types.h"
+#include "utils.h"
+#include "simd.h"
+
+/**
+ * Decode throughput of NDB_CRYPT_PERMUTE and NDB_CRYPT_CYCLIC, and the throughput of the block
+ * CRC, for the table code and every vectorized kernel the CPU supports. Runs over 8 KiB blocks
+ * like the ones a DataTree decodes.
+*/
+namespace crypt_bench
+{
+    using namespace storyt;
+
+    const char* name(simd::ISA isa)
+    {
+        switch (isa)
+        {
+        case simd::ISA::Scalar: return "byte loop:   ";
+        case simd::ISA::AVX2: return "avx2:        ";
+        case simd::ISA::AVX512VBMI: return "avx512 vbmi: ";
+        case simd::ISA::PCLMUL: return "pclmul:      ";
+        }
+        return "";
+    }
+
+    template<typename Crypt>
+    double megabytesPerSecond(std::vector<types::byte_t>& block, size_t nRounds, Crypt crypt)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nRounds; ++i)
+        {
+            crypt(i);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(block.size() * nRounds) / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    using namespace crypt_bench;
+
+    std::vector<types::byte_t> original(8192);
+    for (size_t i = 0; i < original.size(); ++i)
+    {
+        original[i] = static_cast<types::byte_t>(i * 7U);
+    }
+    const size_t nRounds = 20000; // Even, so every run leaves the block as it started
+    bool ok = true;
+    for (const simd::ISA isa : { simd::ISA::Scalar, simd::ISA::AVX2, simd::ISA::AVX512VBMI })
+    {
+        if (!simd::isSupported(isa))
+        {
+            continue;
+        }
+        std::vector<types::byte_t> block(original);
+        const double permute = megabytesPerSecond(block, nRounds, 
+            [&block, isa](size_t i) { simd::CryptPermute(block, (i & 1U) == 0, isa); });
+        // Cyclic is its own inverse
+        const double cyclic = megabytesPerSecond(block, nRounds, 
+            [&block, isa](size_t) { simd::CryptCyclic(block, 0x1234FFF0U, isa); });
+        std::cout << name(isa) << static_cast<uint64_t>(permute) << " MB/s permute, " 
+            << static_cast<uint64_t>(cyclic) << " MB/s cyclic\n";
+        ok = ok && block == original;
+    }
+    uint32_t expectedCRC{ 0 };
+    for (const simd::ISA isa : { simd::ISA::Scalar, simd::ISA::PCLMUL })
+    {
+        if (!simd::isSupported(isa))
+        {
+            continue;
+        }
+        uint32_t crc{ 0 };
+        const double crcSpeed = megabytesPerSecond(original, nRounds, 
+            [&original, &crc, isa](size_t) { crc = simd::ComputeCRC(crc, original, isa); });
+        std::cout << name(isa) << static_cast<uint64_t>(crcSpeed) << " MB/s crc\n";
+        expectedCRC = isa == simd::ISA::Scalar ? crc : expectedCRC;
+        ok = ok && crc == expectedCRC;
+    }
+    return ok ? 0 : 1;
+}
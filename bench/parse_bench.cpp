@@ -0,0 +1,148 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "types.h"
+#include "utils.h"
+#include "core.h"
+#include "NDB.h"
+#include "LTP.h"
+
+/**
+ * Parsing throughput of the little endian field reads every structure is built from, of whole
+ * BTPages and of the PC records in a heap block. Field reads are compared against the
+ * slice -> pad -> toT_l path ByteView::read<T> used before it read straight from the span.
+*/
+namespace parse_bench
+{
+    using namespace storyt::types;
+    using namespace storyt::core;
+    using namespace storyt::ndb;
+    using namespace storyt::ltp;
+
+    void write(std::vector<byte_t>& bytes, size_t offset, uint64_t value, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            bytes[offset + i] = static_cast<byte_t>(value >> (8 * i));
+        }
+    }
+
+    /// The read ByteView::read<T> did before: a vector for the slice and another for the padding.
+    template<typename T>
+    T allocatingRead(const std::vector<byte_t>& bytes, size_t start, size_t size)
+    {
+        const std::vector<byte_t> slice(bytes.begin() + start, bytes.begin() + start + size);
+        const std::vector<byte_t> padded = storyt::utils::pad(slice, sizeof(T) - slice.size());
+        T value{ 0 };
+        for (size_t i = padded.size(); i > 0; --i)
+        {
+            value = static_cast<T>((static_cast<uint64_t>(value) << 8) | padded[i - 1]);
+        }
+        return value;
+    }
+
+    std::vector<byte_t> makeNBTPage()
+    {
+        std::vector<byte_t> page(BTPage::size, 0);
+        const size_t nEntries = 15;
+        for (size_t i = 0; i < nEntries; ++i)
+        {
+            write(page, i * 0x20, (i + 1) * 0x20, 8);
+            write(page, i * 0x20 + 8, (i + 1) * 4, 8);
+        }
+        page[488] = static_cast<byte_t>(nEntries);
+        page[489] = static_cast<byte_t>(488 / 0x20);
+        page[490] = 0x20;
+        page[491] = 0;
+        page[496] = 0x81; // ptypeNBT
+        page[497] = 0x81;
+        return page;
+    }
+
+    /// A PC heap block: the HNHDR, nRecords PC BTH records of 8 bytes and the HNPAGEMAP.
+    std::vector<byte_t> makeHeapBlock(size_t nRecords)
+    {
+        const size_t ibHnpm = 12 + nRecords * 8;
+        std::vector<byte_t> block(ibHnpm + 4 + (nRecords + 1) * 2, 0);
+        write(block, 0, ibHnpm, 2);
+        block[2] = 0xEC;
+        block[3] = 0xBC;
+        for (size_t i = 0; i < nRecords; ++i)
+        {
+            write(block, 12 + i * 8, 0x3000 + i, 2); // wPropId
+            write(block, 12 + i * 8 + 2, 0x0003, 2); // wPropType = PtypInteger32
+            write(block, 12 + i * 8 + 4, i, 4);
+        }
+        write(block, ibHnpm, nRecords, 2);
+        for (size_t i = 0; i <= nRecords; ++i)
+        {
+            write(block, ibHnpm + 4 + i * 2, 12 + i * 8, 2);
+        }
+        return block;
+    }
+
+    template<typename Parse>
+    double perSecond(size_t nRounds, size_t itemsPerRound, Parse parse)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nRounds; ++i)
+        {
+            parse(i);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(nRounds * itemsPerRound) / elapsed.count();
+    }
+}
+
+int main()
+{
+    using namespace parse_bench;
+
+    // The fields of 1024 NBT entries: NID (4 of 8 bytes), two BIDs and the parent NID.
+    const size_t nEntries = 1024;
+    std::vector<byte_t> entries(nEntries * 32);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i] = static_cast<byte_t>(i * 13U);
+    }
+    const size_t nFieldRounds = 2000000;
+    uint64_t checksumBefore{ 0 };
+    uint64_t checksumAfter{ 0 };
+    const double fieldsBefore = perSecond(nFieldRounds, 4, [&](size_t i) {
+        const size_t offset = (i % nEntries) * 32;
+        checksumBefore += allocatingRead<uint32_t>(entries, offset, 4) + allocatingRead<uint64_t>(entries, offset + 8, 8)
+            + allocatingRead<uint64_t>(entries, offset + 16, 8) + allocatingRead<uint32_t>(entries, offset + 24, 4);
+    });
+    const double fieldsAfter = perSecond(nFieldRounds, 4, [&](size_t i) {
+        storyt::utils::ByteView view(std::span<const byte_t>(entries).subspan((i % nEntries) * 32, 32));
+        checksumAfter += view.read<uint32_t>(4) + view.skip(4).read<uint64_t>(8) + view.read<uint64_t>(8) + view.read<uint32_t>(4);
+    });
+
+    const std::vector<byte_t> page = makeNBTPage();
+    uint64_t pageChecksum{ 0 };
+    const double pages = perSecond(200000, 1, [&](size_t) {
+        pageChecksum += BTPage::Init(page).nEntries;
+    });
+
+    const size_t nRecords = 64;
+    const std::vector<byte_t> heap = makeHeapBlock(nRecords);
+    uint64_t heapChecksum{ 0 };
+    const double records = perSecond(100000, nRecords, [&](size_t) {
+        const HNHDR hnhdr = HN::readHNHDR(heap, 0, 1, false);
+        const HNPageMap map = HN::readHNPageMap(heap, hnhdr.ibHnpm, false);
+        for (size_t i = 1; i < map.rgibAlloc.size(); ++i)
+        {
+            const std::span<const byte_t> alloc = std::span<const byte_t>(heap).subspan(map.rgibAlloc[i - 1], 8);
+            heapChecksum += Record(alloc, 2, 6).as<PCBTHRecord>().wPropId;
+        }
+    });
+
+    std::cout << "allocating field reads:  " << static_cast<uint64_t>(fieldsBefore) << " fields/s\n";
+    std::cout << "span field reads:        " << static_cast<uint64_t>(fieldsAfter) << " fields/s\n";
+    std::cout << "speedup:                 " << fieldsAfter / fieldsBefore << "x\n";
+    std::cout << "NBT BTPage::Init:        " << static_cast<uint64_t>(pages) << " pages/s\n";
+    std::cout << "PC heap records:         " << static_cast<uint64_t>(records) << " records/s\n";
+    std::cout << "checksum:                " << (pageChecksum + heapChecksum) % 10 << "\n";
+    return checksumBefore == checksumAfter ? 0 : 1;
+}
@@ -7,6 +7,11 @@
 #include <algorithm>
 #include <unordered_map>
 #include <numeric>
+#include <functional>
+#include <span>
+#include <array>
+#include <deque>
+#include <optional>
 
 #include "types.h"
 #include "utils.h"
@@ -27,8 +32,8 @@ namespace storyt::ltp {
 		static constexpr size_t SizeNBytes = 4;
 	public:
 		HID() = default;
-		explicit HID(const std::vector<types::byte_t>& data)
-			: m_hid(utils::slice(data, 0, 4, 4, utils::toT_l<uint32_t>))
+		explicit HID(std::span<const types::byte_t> data)
+			: m_hid(utils::loadLE<uint32_t>(data.first(4)))
 		{
 			STORYT_ASSERT((utils::getNIDType(getHIDType()) == types::NIDType::HID),
 				"Invalid HID Type");
@@ -79,10 +84,10 @@ namespace storyt::ltp {
 	{
 	public:
 		HNID() = default;
-		explicit HNID(const std::vector<types::byte_t>& data)
-			: m_data(data)
+		explicit HNID(std::span<const types::byte_t> data)
 		{
-			STORYT_ASSERT((m_data.size() == HNID::sizeNBytes), "m_data.size() [{}] == HNID::sizeNBytes [4]", m_data.size());
+			STORYT_ASSERT((data.size() == HNID::sizeNBytes), "data.size() [{}] == HNID::sizeNBytes [4]", data.size());
+			std::copy(data.begin(), data.end(), m_data.begin());
 		}
 
 		[[nodiscard]] bool isHID() const
@@ -113,7 +118,7 @@ namespace storyt::ltp {
 		}
 		constexpr static size_t sizeNBytes = 4;
 	private:
-		std::vector<types::byte_t> m_data{};
+		std::array<types::byte_t, sizeNBytes> m_data{};
 	};
 
 	/**
@@ -229,7 +234,7 @@ namespace storyt::ltp {
 		/// item that contains the next level index record array.
 		HID hidNextLevel{};
 
-		IntermediateBTHRecord(const std::vector<types::byte_t>& bytes, size_t keySize, size_t dataSize)
+		IntermediateBTHRecord(std::span<const types::byte_t> bytes, size_t keySize, size_t dataSize)
 		{
 			STORYT_ASSERT((keySize <= sizeof(uint64_t)), "keySize is not <= sizeof(uint64_t)");
 			STORYT_ASSERT((dataSize == HID::SizeNBytes), "dataSize != HID::SizeNBytes");
@@ -286,7 +291,7 @@ namespace storyt::ltp {
 		/// to an NID indicates that the item is stored in the subnode block, and the 
 		/// NID is the local NID under
 		///	the subnode where the raw data is located.
-		std::vector<types::byte_t> dwValueHnid{};
+		std::array<types::byte_t, 4> dwValueHnid{};
 		//HNID dwValueHnid{};
 
 		/*
@@ -432,11 +437,14 @@ namespace storyt::ltp {
 	class Record
 	{
 	public:
-		Record(const std::vector<types::byte_t>& data, size_t keySize, size_t dataSize = 0)
-			: m_data(data), m_keySize(keySize), m_dataSize(dataSize) {}
+		/**
+		 * @param data = a view into the HN the record was read from. It is NOT copied.
+		*/
+		Record(std::span<const types::byte_t> data, size_t keySize, size_t dataSize = 0)
+			: m_keySize(keySize), m_dataSize(dataSize), m_data(data) {}
 
 		static IntermediateBTHRecord asIntermediateBTHRecord(
-			const std::vector<types::byte_t>& bytes,
+			std::span<const types::byte_t> bytes,
 			size_t keySize
 		)
 		{
@@ -445,7 +453,7 @@ namespace storyt::ltp {
 		}
 
 		static LeafBTHRecord asLeafBTHRecord(
-			const std::vector<types::byte_t>& bytes,
+			std::span<const types::byte_t> bytes,
 			size_t keySize,
 			size_t dataSize
 		)
@@ -459,7 +467,7 @@ namespace storyt::ltp {
 		}
 
 		static PCBTHRecord asPCBTHRecord(
-			const std::vector<types::byte_t>& bytes,
+			std::span<const types::byte_t> bytes,
 			size_t keySize,
 			size_t dataSize
 		)
@@ -471,14 +479,14 @@ namespace storyt::ltp {
 			PCBTHRecord record{};
 			record.wPropId = view.read<uint16_t>(2);
 			record.wPropType = view.read<uint16_t>(2);
-			record.dwValueHnid = view.read(4); 
+			std::ranges::copy(view.readView(4), record.dwValueHnid.begin());
 
 			STORYT_ASSERT((utils::isIn(record.wPropType, utils::PROPERTY_TYPE_VALUES)), "Invalid property type");
 			return record;
 		}
 
 		static TCRowID asTCRowID(
-			const std::vector<types::byte_t>& bytes,
+			std::span<const types::byte_t> bytes,
 			size_t keySize,
 			size_t dataSize
 		)
@@ -493,6 +501,12 @@ namespace storyt::ltp {
 			return record;
 		}
 
+		/// A view of the key bytes at the start of the record
+		[[nodiscard]] std::span<const types::byte_t> key() const
+		{
+			return m_data.first(std::min(m_keySize, m_data.size()));
+		}
+
 		template<typename RecordType>
 		[[nodiscard]] RecordType as() const
 		{
@@ -520,7 +534,7 @@ namespace storyt::ltp {
 	private:
 		size_t m_keySize{};
 		size_t m_dataSize{};
-		std::vector<types::byte_t> m_data{};
+		std::span<const types::byte_t> m_data{};
 	};
 
 	struct HNBlock
@@ -530,8 +544,8 @@ namespace storyt::ltp {
 		HNPageHDR pheader{}; 
 		/// will only be present in 8th block and every 8 + 128 block thereafter
 		HNBitMapHDR bmheader{};
-		/// this data is not trimmed. It includes everything
-		std::vector<types::byte_t> data{};
+		/// this data is not trimmed. It includes everything. A view into the buffer of the HN's DataTree.
+		std::span<const types::byte_t> data{};
 	};
 
 	/**
@@ -562,13 +576,13 @@ namespace storyt::ltp {
 			return HN(nid, std::move(dtree));
 		}
 
-		bool addBlock(const std::vector<types::byte_t>& data, size_t blockIdx)
+		bool addBlock(std::span<const types::byte_t> data, size_t blockIdx)
 		{
 			STORYT_ASSERT((m_blocks.size() == blockIdx), "m_blocks.size() != blockIdx");
 			if(blockIdx == 8 || blockIdx % 8 + 128 == 0)
 			{
 				const HNBitMapHDR bmheader = readHNBitMapHDR(data);
-				const HNPageMap map = readHNPageMap(data, bmheader.ibHnpm);
+				const HNPageMap map = readHNPageMap(data, bmheader.ibHnpm, shouldValidate(readOptions().ltp));
 				HNBlock block{};
 				block.bmheader = bmheader;
 				block.map = map;
@@ -578,7 +592,7 @@ namespace storyt::ltp {
 			else
 			{
 				const HNPageHDR pheader = readHNPageHDR(data);
-				const HNPageMap map = readHNPageMap(data, pheader.ibHnpm);
+				const HNPageMap map = readHNPageMap(data, pheader.ibHnpm, shouldValidate(readOptions().ltp));
 				HNBlock block{};
 				block.pheader = pheader;
 				block.map = map;
@@ -591,7 +605,11 @@ namespace storyt::ltp {
 		[[nodiscard]] types::BType getBType() const { return utils::toBType(m_hnhdr.bClientSig); }
 		[[nodiscard]] HNHDR getHeader() const { return m_hnhdr; }
 		[[nodiscard]] const HNBlock& at(size_t blockIdx) const { return m_blocks.at(blockIdx); }
-		[[nodiscard]] std::vector<types::byte_t> getAllocation(const HID& hid) const
+		/**
+		 * @brief A view of the heap item with hid. It points into the HN's DataTree buffer so it stays valid for
+		 *  as long as this HN, or any copy of it, is alive. Empty when hid is not valid.
+		*/
+		[[nodiscard]] std::span<const types::byte_t> getAllocation(const HID& hid) const
 		{
 			if (hid.IsHIDValid())
 			{
@@ -601,15 +619,18 @@ namespace storyt::ltp {
 				const size_t start = static_cast<size_t>(block.map.rgibAlloc.at(pageIdx - 1));
 				const size_t end = static_cast<size_t>(block.map.rgibAlloc.at(pageIdx));
 				const size_t size = end - start;
-				return utils::slice(block.data, start, end, size);
+				STORYT_ASSERT((end <= block.data.size()), "HN Allocation [{}, {}) runs past the end of block [{}]", start, end, blockIdx);
+				return block.data.subspan(start, size);
 			}
 			STORYT_ERROR("Failed to get HN Allocation because HID [{}] was NOT valid", hid.getHIDRaw());
 			return {};
 		}
 
 		[[nodiscard]] size_t nblocks() const { return m_blocks.size(); }
+		[[nodiscard]] const core::ReadOptions& readOptions() const { return m_dataTree.readOptions(); }
+		[[nodiscard]] bool shouldValidate(core::Validation level) const { return m_dataTree.shouldValidate(level); }
 
-		static HNHDR readHNHDR(const std::vector<types::byte_t>& bytes, size_t dataBlockIdx, size_t nDataBlocks)
+		static HNHDR readHNHDR(std::span<const types::byte_t> bytes, size_t dataBlockIdx, size_t nDataBlocks, bool validate = true)
 		{
 			STORYT_ASSERT((dataBlockIdx == 0), "Only the first data block contains a HNHDR");
 			utils::ByteView view(bytes);
@@ -619,6 +640,10 @@ namespace storyt::ltp {
 			hnhdr.bClientSig = view.read<uint8_t>(1); 
 			hnhdr.hidUserRoot = view.entry<HID>(4); 
 			hnhdr.rgbFillLevel = view.split(4); //utils::toBits(utils::slice(bytes, 8, 12, 4, utils::toT_l<uint32_t>), 4);
+			if (!validate)
+			{
+				return hnhdr;
+			}
 
 			const uint32_t hidType = hnhdr.hidUserRoot.getHIDType();
 			STORYT_ASSERT((hidType == 0), "Invalid HID Type [{}]", hidType);
@@ -637,13 +662,17 @@ namespace storyt::ltp {
 			return hnhdr;
 		}
 
-		static HNPageMap readHNPageMap(const std::vector<types::byte_t>& bytes, size_t start)
+		static HNPageMap readHNPageMap(std::span<const types::byte_t> bytes, size_t start, bool validate = true)
 		{
 			utils::ByteView view(bytes, start);
 			HNPageMap pg{};
 			pg.cAlloc = view.read<uint16_t>(2);
 			pg.cFree = view.read<uint16_t>(2); 
 			pg.rgibAlloc = view.read<uint16_t>(pg.cAlloc + 1, 2);
+			if (!validate)
+			{
+				return pg;
+			}
 			STORYT_ASSERT((pg.rgibAlloc.size() == pg.cAlloc + 1), "Should be cAlloc + 1 entries");
 
 			for (size_t i = 1; i < pg.rgibAlloc.size(); i++)
@@ -668,7 +697,7 @@ namespace storyt::ltp {
 			return pg;
 		}
 
-		static HNPageHDR readHNPageHDR(const std::vector<types::byte_t>& bytes)
+		static HNPageHDR readHNPageHDR(std::span<const types::byte_t> bytes)
 		{
 			// HNPageHDR should be the first 2 bytes in bytes vector
 			utils::ByteView view(bytes);
@@ -677,7 +706,7 @@ namespace storyt::ltp {
 			return hdr;
 		}
 
-		static HNBitMapHDR readHNBitMapHDR(const std::vector<types::byte_t>& bytes)
+		static HNBitMapHDR readHNBitMapHDR(std::span<const types::byte_t> bytes)
 		{
 			utils::ByteView view(bytes);
 			HNBitMapHDR hdr{};
@@ -696,22 +725,25 @@ namespace storyt::ltp {
 				static_assert(std::is_copy_constructible_v<HN>, "HN must be copy constructible");
 				static_assert(std::is_copy_assignable_v<HN>, "HN must be copy assignable");
 
-				size_t idx = 0;	
-				for (ndb::DataBlock& dataBlock : m_dataTree)
+				const bool validate = shouldValidate(readOptions().ltp);
+				// Every HNBlock views the DataTree's buffer which is shared, not copied, when the HN is copied.
+				m_dataTree.load();
+				m_blocks.reserve(m_dataTree.nDataBlocks());
+				for (size_t idx = 0; idx < m_dataTree.nDataBlocks(); ++idx)
 				{
+					const std::span<const types::byte_t> data = m_dataTree.blockData(idx);
 					if (idx == 0)
 					{
-						m_hnhdr = readHNHDR(dataBlock.data, 0, m_dataTree.nDataBlocks());
+						m_hnhdr = readHNHDR(data, 0, m_dataTree.nDataBlocks(), validate);
 						HNBlock block{};
-						block.map = readHNPageMap(dataBlock.data, m_hnhdr.ibHnpm);
-						block.data = std::move(dataBlock.data);
+						block.map = readHNPageMap(data, m_hnhdr.ibHnpm, validate);
+						block.data = data;
 						m_blocks.push_back(block);
 					}
 					else
 					{
-						addBlock(dataBlock.data, idx);
+						addBlock(data, idx);
 					}
-					++idx;
 				}
 			}
 
@@ -731,22 +763,11 @@ namespace storyt::ltp {
 			static_assert(std::is_move_assignable_v<BTreeHeap>, "BTreeHeap must be move assignable");
 			static_assert(std::is_copy_constructible_v<BTreeHeap>, "BTreeHeap must be copy constructible");
 			static_assert(std::is_copy_assignable_v<BTreeHeap>, "BTreeHeap must be copy assignable");
-			const std::vector<types::byte_t> headerBytes = hn.getAllocation(bthHeaderHID);
-			m_header = readBTHHeader(headerBytes);
-
-			if (m_header.hidRoot.getHIDRaw() > 0) // If hidRoot is zero, the BTH is empty
-			{
-				m_records = readBTHRecords(
-					hn,
-					hn.getAllocation(m_header.hidRoot),
-					m_header.cbKey,
-					m_header.bIdxLevels,
-					m_header.cbEnt
-				);
-			}
+			// Only the header is read here. Records are found with find or read all at once by records.
+			m_header = readBTHHeader(hn.getAllocation(bthHeaderHID));
 		}
 
-		static BTHHeader readBTHHeader(const std::vector<types::byte_t>& bytes)
+		static BTHHeader readBTHHeader(std::span<const types::byte_t> bytes)
 		{
 			STORYT_ASSERT((bytes.size() == 8), "readBTHHeader");
 			utils::ByteView view{bytes};
@@ -769,35 +790,18 @@ namespace storyt::ltp {
 			return header;
 		}
 
-		std::vector<Record> readBTHRecords(
+		/**
+		 * @brief The leaf records of the BTH in key order. Each Record is a view into hn so hn, or a copy of it, must outlive them.
+		*/
+		static std::vector<Record> readBTHRecords(
 			const HN& hn,
-			const std::vector<types::byte_t>& bytes,
+			std::span<const types::byte_t> bytes,
 			size_t keySize,
 			size_t bIdxLevels,
 			size_t dataSize = 0)
 		{
-			const size_t rsize = keySize + dataSize;
-			const size_t nRecords = bytes.size() / rsize;
-			STORYT_ASSERT((bytes.size() % rsize == 0), "nRecords must be a mutiple of keySize + dataSize");
-
-			if (bIdxLevels > 0)
-			{
-				STORYT_ASSERT((dataSize == HID::SizeNBytes), "readBTHRecords");
-				utils::ByteView view(bytes);
-				std::vector<IntermediateBTHRecord> inters = view.entries<IntermediateBTHRecord>(nRecords, rsize, keySize, dataSize);
-				std::vector<types::byte_t> totalBytes{};
-				for (const auto& inter : inters)
-				{
-					std::vector<types::byte_t> alloc = hn.getAllocation(inter.hidNextLevel);
-					totalBytes.insert(totalBytes.end(), alloc.begin(), alloc.end());
-				}
-				return readBTHRecords(hn, totalBytes, keySize, bIdxLevels - 1, dataSize);
-			}
-
-			STORYT_ASSERT((bIdxLevels == 0), "bIdxLevels != 0 [{}]", bIdxLevels);
-			utils::ByteView view(bytes);
-			std::vector<Record> records = view.entries<Record>(nRecords, rsize, keySize, dataSize);
-			STORYT_ASSERT((records.size() == nRecords), "Invalid size");
+			std::vector<Record> records{};
+			_readBTHRecords(hn, bytes, keySize, bIdxLevels, dataSize, records);
 			return records;
 		}
 
@@ -820,18 +824,163 @@ namespace storyt::ltp {
 			return m_header.cbEnt;
 		}
 
-		[[nodiscard]] size_t nrecords() const
+		/**
+		 * @brief Finds the record with key by binary searching each level of the BTH so only the allocations on the
+		 *  path down to it are touched. The record is a view into hn.
+		 *  Keys wider than 8 bytes, e.g. the 16 byte GUIDs of a Name-to-ID map, do not fit the binary search so they
+		 *  are matched against every record instead. key is zero extended to the width of the BTH's keys.
+		 * @param hn = the HN this BTreeHeap was created from or a copy of it.
+		*/
+		[[nodiscard]] std::optional<Record> find(const HN& hn, uint64_t key) const
 		{
-			return m_records.size();
+			if (empty())
+			{
+				return std::nullopt;
+			}
+			if (m_header.cbKey > sizeof(uint64_t))
+			{
+				return _scan(hn, key);
+			}
+			std::span<const types::byte_t> level = hn.getAllocation(m_header.hidRoot);
+			for (size_t i = m_header.bIdxLevels; i > 0; --i)
+			{
+				// An intermediate record covers every key from its own up to the key of the next record.
+				const size_t rsize = m_header.cbKey + HID::SizeNBytes;
+				const size_t idx = _upperBound(level, rsize, key);
+				if (idx == 0)
+				{
+					return std::nullopt;
+				}
+				level = hn.getAllocation(HID(level.subspan((idx - 1) * rsize + m_header.cbKey, HID::SizeNBytes)));
+			}
+			const size_t rsize = m_header.cbKey + m_header.cbEnt;
+			const size_t idx = _upperBound(level, rsize, key);
+			if (idx == 0 || _keyAt(level, rsize, idx - 1) != key)
+			{
+				return std::nullopt;
+			}
+			return Record(level.subspan((idx - 1) * rsize, rsize), m_header.cbKey, m_header.cbEnt);
 		}
 
-		[[nodiscard]] const std::vector<Record>& records() const
+		/**
+		 * @brief Every leaf record in key order. They are only read the first time this is called.
+		 * @param hn = the HN this BTreeHeap was created from or a copy of it.
+		*/
+		[[nodiscard]] const std::vector<Record>& records(const HN& hn) const
 		{
+			if (!m_recordsAreLoaded && !empty())
+			{
+				m_records = readBTHRecords(hn, hn.getAllocation(m_header.hidRoot), m_header.cbKey, m_header.bIdxLevels, m_header.cbEnt);
+			}
+			m_recordsAreLoaded = true;
 			return m_records;
 		}
+
+		[[nodiscard]] size_t nrecords(const HN& hn) const
+		{
+			return records(hn).size();
+		}
+
+		/**
+		 * @brief The number of leaf records when it is known without reading them, which is when the root is the
+		 *  only leaf (bIdxLevels == 0). Otherwise 0.
+		*/
+		[[nodiscard]] size_t nLeafRecordsHint(const HN& hn) const
+		{
+			if (empty() || m_header.bIdxLevels != 0)
+			{
+				return 0;
+			}
+			return hn.getAllocation(m_header.hidRoot).size() / (m_header.cbKey + m_header.cbEnt);
+		}
+
+	private:
+		/**
+		 * @brief Only for keys no wider than 8 bytes. find falls back to _scan for wider ones.
+		*/
+		[[nodiscard]] uint64_t _keyAt(std::span<const types::byte_t> level, size_t rsize, size_t idx) const
+		{
+			STORYT_ASSERT((m_header.cbKey <= sizeof(uint64_t)), "Keys of [{}] bytes do not fit a uint64_t", m_header.cbKey);
+			return utils::loadLE<uint64_t>(level.subspan(idx * rsize, std::min<size_t>(m_header.cbKey, sizeof(uint64_t))));
+		}
+
+		[[nodiscard]] std::optional<Record> _scan(const HN& hn, uint64_t key) const
+		{
+			for (const Record& record : records(hn))
+			{
+				const std::span<const types::byte_t> bytes = record.key();
+				const std::span<const types::byte_t> high = bytes.subspan(std::min(bytes.size(), sizeof(uint64_t)));
+				if (utils::loadLE<uint64_t>(bytes) == key && std::ranges::all_of(high, [](types::byte_t b) { return b == 0; }))
+				{
+					return record;
+				}
+			}
+			return std::nullopt;
+		}
+
+		/**
+		 * @brief The index of the first record in level with a key greater than key.
+		*/
+		[[nodiscard]] size_t _upperBound(std::span<const types::byte_t> level, size_t rsize, uint64_t key) const
+		{
+			STORYT_ASSERT((level.size() % rsize == 0), "nRecords must be a mutiple of keySize + dataSize");
+			size_t lo{ 0 };
+			size_t hi{ level.size() / rsize };
+			while (lo < hi)
+			{
+				const size_t mid = lo + (hi - lo) / 2;
+				if (_keyAt(level, rsize, mid) <= key)
+				{
+					lo = mid + 1;
+				}
+				else
+				{
+					hi = mid;
+				}
+			}
+			return lo;
+		}
+
+		/**
+		 * @brief Each intermediate level points at its children by HID so they are walked in order straight
+		 *  from the heap instead of being appended into one buffer first.
+		 * @param dataSize = the size of the leaf records' data. Intermediate records always hold a HID instead.
+		*/
+		static void _readBTHRecords(
+			const HN& hn,
+			std::span<const types::byte_t> bytes,
+			size_t keySize,
+			size_t bIdxLevels,
+			size_t dataSize,
+			std::vector<Record>& out)
+		{
+			if (bIdxLevels > 0)
+			{
+				const size_t isize = keySize + HID::SizeNBytes;
+				STORYT_ASSERT((bytes.size() % isize == 0), "nRecords must be a mutiple of keySize + HID::SizeNBytes");
+				utils::ByteView view(bytes);
+				const std::vector<IntermediateBTHRecord> inters = view.entries<IntermediateBTHRecord>(bytes.size() / isize, isize, keySize, HID::SizeNBytes);
+				for (const auto& inter : inters)
+				{
+					_readBTHRecords(hn, hn.getAllocation(inter.hidNextLevel), keySize, bIdxLevels - 1, dataSize, out);
+				}
+				return;
+			}
+
+			const size_t rsize = keySize + dataSize;
+			const size_t nRecords = bytes.size() / rsize;
+			STORYT_ASSERT((bytes.size() % rsize == 0), "nRecords must be a mutiple of keySize + dataSize");
+			out.reserve(out.size() + nRecords);
+			for (size_t i = 0; i < nRecords; ++i)
+			{
+				out.emplace_back(bytes.subspan(i * rsize, rsize), keySize, dataSize);
+			}
+		}
+
 	private:
 		BTHHeader m_header;
-		std::vector<Record> m_records;
+		mutable std::vector<Record> m_records{};
+		mutable bool m_recordsAreLoaded{ false };
 	};
 
 	/**
@@ -900,21 +1049,37 @@ namespace storyt::ltp {
 	class Property
 	{
 	public:
+		/// Values up to this size are copied into the Property itself.
+		static constexpr size_t InlineSize = 8;
+
 		uint32_t id{};
 		types::PropertyType propType{ types::PropertyType::Null };
 		utils::PTInfo info{};
-		std::vector<types::byte_t> data{};
 		bool isLoaded{ false };
 
 	public:
+		/**
+		 * @brief The HNID until the property is loaded, then its value. Larger values are views into the
+		 *  heap or the subnode DataTree of the PropertyContext and are only valid for as long as it is.
+		*/
+		[[nodiscard]] std::span<const types::byte_t> data() const
+		{
+			if (m_isInline)
+			{
+				return std::span<const types::byte_t>(m_inline).first(m_inlineSize);
+			}
+			return m_view;
+		}
+
 		[[nodiscard]] PTBinary asPTBinary() const
 		{
 			STORYT_ASSERT(!info.isMv, "Property is not a PTBinary");
 			STORYT_ASSERT(!info.isFixed, "Property is not a PTBinary");
 			STORYT_ASSERT(info.singleEntrySize == 0ULL, "Property is not a PTBinary");
+			const std::span<const types::byte_t> value = data();
 			PTBinary bin{};
 			bin.id = id;
-			bin.data = data;
+			bin.data.assign(value.begin(), value.end());
 			return bin;
 		}
 
@@ -928,19 +1093,20 @@ namespace storyt::ltp {
 				"Property is not a PTString with PID [{}] and PropType [{}] because it is marked as Fixed", upid, uptype);
 			STORYT_ASSERT((info.singleEntrySize == 2ULL), 
 				"Property is not a PTString with PID [{}] and PropType [{}] because entry size [{}] != [2]", upid, uptype, info.singleEntrySize);
-			STORYT_ASSERT((data.size() % 2ULL == 0ULL), 
-				"Property is not a PTString with PID [{}] and PropType [{}] because data.size() % 2 != 0 but [{}]", upid, uptype, (data.size() % 2ULL));
-			STORYT_ASSERT((data.size() != 0ULL), 
+			const std::span<const types::byte_t> value = data();
+			STORYT_ASSERT((value.size() % 2ULL == 0ULL), 
+				"Property is not a PTString with PID [{}] and PropType [{}] because data.size() % 2 != 0 but [{}]", upid, uptype, (value.size() % 2ULL));
+			STORYT_ASSERT((value.size() != 0ULL), 
 				"Property is not a PTString with PID [{}] and PropType [{}] because data.size() == 0", upid, uptype);
 			PTString str{};
 			str.id = id;
-			str.data = utils::UTF16BytesToString(data);
+			str.data = utils::UTF16BytesToString(value);
 			return str;
 		}
 
 		[[nodiscard]] int32_t asPTInt32() const
 		{
-			utils::ByteView view(data);
+			utils::ByteView view(data());
 			return view.read<int32_t>(4U);
 		}
 
@@ -969,20 +1135,47 @@ namespace storyt::ltp {
 
 		[[nodiscard]] bool DataIsInHeap() const
 		{
-			STORYT_ASSERT((data.size() == 4), "Data should be an HNID");
-			return (info.isFixed && info.singleEntrySize > 4U) || (data[0] & 0x1FU) == 0U;
+			STORYT_ASSERT((data().size() == 4), "Data should be an HNID");
+			return (info.isFixed && info.singleEntrySize > 4U) || (m_inline[0] & 0x1FU) == 0U;
 		}
 
 		[[nodiscard]] bool DataIsInSubNodeTree() const
 		{
 			return !DataIsInHNID() && !DataIsInHeap();
 		}
+
+	private:
+		friend class PropertyContext;
+
+		/// Small values are copied inline. Anything larger is kept as a view and never copied.
+		void _setData(std::span<const types::byte_t> value)
+		{
+			m_isInline = value.size() <= InlineSize;
+			if (m_isInline)
+			{
+				std::ranges::copy(value, m_inline.begin());
+				m_inlineSize = static_cast<uint8_t>(value.size());
+				m_view = {};
+			}
+			else
+			{
+				m_view = value;
+			}
+		}
+
+	private:
+		std::array<types::byte_t, InlineSize> m_inline{};
+		uint8_t m_inlineSize{ 0 };
+		bool m_isInline{ true };
+		std::span<const types::byte_t> m_view{};
 	};
 
 	class PropertyContext
 	{
 	public:
 		using PropertyID_t = uint32_t;
+		/// Receives each chunk of a streamed property value. The chunk is only valid during the call.
+		using Sink_t = std::function<void(std::span<const types::byte_t>)>;
 	public:
 		static PropertyContext Init(
 			core::NID nid,
@@ -1017,12 +1210,13 @@ namespace storyt::ltp {
 		}
 		[[nodiscard]] Property* TryToGetProperty(uint32_t pid, types::PropertyType propType)
 		{
-			_loadProperty(pid); // attempt to load property
-			if (HasPropertyWPidAndPtypeOf(pid, propType))
+			Property* prop = _findProperty(pid);
+			if (prop == nullptr || prop->propType != propType)
 			{
-				return &m_properties.at(pid);
+				return nullptr;
 			}
-			return nullptr;
+			_loadProperty(*prop); // attempt to load property
+			return prop;
 		}
 		[[nodiscard]] Property* TryToGetProperty(types::PidTagTypeCombo::Info info)
 		{
@@ -1032,9 +1226,52 @@ namespace storyt::ltp {
 		{
 			return TryToGetProperty(static_cast<uint32_t>(pid), propType);
 		}
+		/**
+		 * @brief Passes a property's value to sink a buffer at a time without ever loading all of it. Values stored in
+		 *  the subnode tree are read block by block through buffer. Values small enough to live in the heap are passed in one chunk.
+		 * @return the size of the value in bytes. 0 when the property does not exist.
+		*/
+		size_t StreamProperty(uint32_t pid, types::PropertyType propType, std::span<types::byte_t> buffer, const Sink_t& sink)
+		{
+			STORYT_ASSERT(!buffer.empty(), "Cannot stream a property through an empty buffer");
+			Property* found = _findProperty(pid);
+			if (found == nullptr || found->propType != propType)
+			{
+				return 0;
+			}
+			const Property& prop = *found;
+			if (prop.isLoaded || prop.DataIsInHNID() || prop.DataIsInHeap())
+			{
+				_loadProperty(*found);
+				sink(prop.data());
+				return prop.data().size();
+			}
+			if (!m_subtree.has_value())
+			{
+				STORYT_ERROR("Attempted to stream a DataTree from an unintialized SubNodeTree");
+				return 0;
+			}
+			std::optional<ndb::DataTreeReader> reader = m_subtree->getDataTreeReader(core::NID(prop.data()));
+			STORYT_ASSERT(reader.has_value(), "Failed to find DataTree for Property [{}]", prop.id);
+			if (!reader.has_value())
+			{
+				return 0;
+			}
+			size_t nBytes{ 0 };
+			for (size_t n = reader->read(buffer); n != 0; n = reader->read(buffer))
+			{
+				sink(buffer.first(n));
+				nBytes += n;
+			}
+			return nBytes;
+		}
+		size_t StreamProperty(types::PidTagTypeCombo::Info info, std::span<types::byte_t> buffer, const Sink_t& sink)
+		{
+			return StreamProperty(info.pid, info.type, buffer, sink);
+		}
 		[[nodiscard]] bool HasPropertyWPidOf(uint32_t pid) const
 		{
-			return m_properties.contains(pid);
+			return _typeOf(pid).has_value();
 		}
 		[[nodiscard]] bool HasPropertyWPidOf(types::PidTagType pid) const
 		{
@@ -1042,15 +1279,7 @@ namespace storyt::ltp {
 		}
 		[[nodiscard]] bool HasPropertyWPidAndPtypeOf(uint32_t pid, types::PropertyType propType) const
 		{
-			if (m_properties.contains(pid))
-			{
-				const Property& prop = m_properties.at(pid);
-				if (prop.propType == propType)
-				{
-					return true;
-				}
-			}
-			return false;
+			return _typeOf(pid) == propType;
 		}
 		[[nodiscard]] bool HasPropertyWPidAndPtypeOf(types::PidTagType pid, types::PropertyType propType) const
 		{
@@ -1060,6 +1289,18 @@ namespace storyt::ltp {
 		{
 			return HasPropertyWPidAndPtypeOf(info.pid, info.type);
 		}
+		[[nodiscard]] core::NID getNID() const
+		{
+			return m_nid;
+		}
+		[[nodiscard]] const core::ReadOptions& readOptions() const
+		{
+			return m_hn.readOptions();
+		}
+		[[nodiscard]] bool shouldValidate(core::Validation level) const
+		{
+			return m_hn.shouldValidate(level);
+		}
 	
 	private:
 		explicit PropertyContext(core::NID nid, HN&& hn)
@@ -1086,8 +1327,14 @@ namespace storyt::ltp {
 		}
 		void _init()
 		{
-			VerifyTableContextIsValid_();
-			_loadMetaProps();
+			if (m_hn.shouldValidate(m_hn.readOptions().ltp))
+			{
+				VerifyTableContextIsValid_();
+			}
+			// Sized once so adding a property to the table never reallocates them
+			const size_t nRecords = m_bth.nLeafRecordsHint(m_hn);
+			m_pids.reserve(nRecords);
+			m_slots.reserve(nRecords);
 		}
 		void VerifyTableContextIsValid_() const
 		{
@@ -1095,26 +1342,24 @@ namespace storyt::ltp {
 			STORYT_ASSERT((m_bth.getKeySize() == 2), "m_bth.getKeySize() != 2");
 			STORYT_ASSERT((m_bth.getDataSize() == 6), "m_bth.getDataSize() != 6");
 		}
-		void _loadProperty(uint32_t propID)
+		void _loadProperty(Property& prop)
 		{
-			Property& prop = m_properties.at(propID);
 			if (prop.isLoaded || prop.DataIsInHNID()) // Data Value or Data for prop has already been loaded
 			{
 				return;
 			}
 			else if (prop.DataIsInHeap()) // HID
 			{
-				const HID id = HID(prop.data);
-				prop.data = m_hn.getAllocation(id);
+				prop._setData(m_hn.getAllocation(HID(prop.data())));
 			}
 			else if (prop.DataIsInSubNodeTree()) // NID
 			{
 				if (m_subtree.has_value())
 				{
-					const core::NID nid(prop.data);
+					const core::NID nid(prop.data());
 					ndb::DataTree* dataPtr = m_subtree->getDataTree(nid);
 					STORYT_ASSERT((dataPtr != nullptr), "Failed to find DataTree for Property [{}]", prop.id);
-					prop.data = dataPtr->combineDataBlocks();
+					prop._setData(dataPtr->data());
 				}
 				else
 				{
@@ -1128,26 +1373,79 @@ namespace storyt::ltp {
 			prop.isLoaded = true;
 		}
 
-		void _loadMetaProps()
+		/**
+		 * @brief Binary search over m_pids. The loop runs log2(n) times no matter where pid is
+		 *  and only the step taken depends on the comparison.
+		 * @return m_pids.size() when pid is not in the table yet.
+		*/
+		[[nodiscard]] size_t _indexOf(uint32_t pid) const
 		{
-			for (const auto& bthRecord : m_bth.records())
+			if (m_pids.empty())
+			{
+				return m_pids.size();
+			}
+			size_t first = 0;
+			for (size_t len = m_pids.size(); len > 1;)
 			{
-				const auto record = bthRecord.as<PCBTHRecord>();
-				const utils::PTInfo info = utils::PropertyTypeInfo(record.wPropType);
-				Property prop{};
-				prop.id = record.wPropId;
-				prop.propType = utils::PropertyType(record.wPropType);
-				prop.info = info;
-				prop.data = record.dwValueHnid;
+				const size_t half = len / 2;
+				first += (m_pids[first + half] <= pid) ? half : 0;
+				len -= half;
+			}
+			return m_pids[first] == pid ? first : m_pids.size();
+		}
 
-				STORYT_ASSERT((!m_properties.contains(prop.id)), "m_properties.contains(prop.id)");
-				m_properties[prop.id] = prop;
+		/**
+		 * @brief The property with pid from the table, or from one BTH lookup the first time pid is found.
+		 *  Only the BTH allocations on the path to pid are read so opening a PC to read a few properties
+		 *  never reads all of its records. A miss is answered by the BTH lookup alone and never allocates
+		 *  or grows the table. A hit is added to the table, whose index was reserved up front when the
+		 *  BTH has a single level, and to m_properties, which allocates a chunk every few properties.
+		 * @return nullptr when the PC has no property with pid.
+		*/
+		[[nodiscard]] Property* _findProperty(uint32_t pid)
+		{
+			if (const size_t idx = _indexOf(pid); idx != m_pids.size())
+			{
+				return &m_properties[m_slots[idx]];
 			}
-			STORYT_ASSERT((m_properties.size() == m_bth.nrecords()), "m_properties.size() != m_bth.nrecords()");
+			const std::optional<Record> bthRecord = m_bth.find(m_hn, pid);
+			if (!bthRecord.has_value())
+			{
+				return nullptr;
+			}
+			const PCBTHRecord record = bthRecord->as<PCBTHRecord>();
+			const auto it = std::lower_bound(m_pids.begin(), m_pids.end(), pid);
+			m_slots.insert(m_slots.begin() + std::distance(m_pids.begin(), it), m_properties.size());
+			m_pids.insert(it, pid);
+			Property& prop = m_properties.emplace_back();
+			prop.id = record.wPropId;
+			prop.propType = utils::PropertyType(record.wPropType);
+			prop.info = utils::PropertyTypeInfo(record.wPropType);
+			prop._setData(record.dwValueHnid);
+			return &prop;
+		}
+
+		/// The type of the property with pid without adding it to the table. std::nullopt when the PC has no property with pid.
+		[[nodiscard]] std::optional<types::PropertyType> _typeOf(uint32_t pid) const
+		{
+			if (const size_t idx = _indexOf(pid); idx != m_pids.size())
+			{
+				return m_properties[m_slots[idx]].propType;
+			}
+			if (const std::optional<Record> bthRecord = m_bth.find(m_hn, pid))
+			{
+				return utils::PropertyType(bthRecord->as<PCBTHRecord>().wPropType);
+			}
+			return std::nullopt;
 		}
 
 	private:
-		std::unordered_map<PropertyID_t, Property> m_properties{};
+		/// The PIDs found so far sorted, searched by _indexOf. m_slots[i] is the index in m_properties
+		/// of the property with m_pids[i].
+		std::vector<PropertyID_t> m_pids{};
+		std::vector<size_t> m_slots{};
+		/// Only ever appended to so the Property pointers handed out stay valid.
+		std::deque<Property> m_properties{};
 		core::NID m_nid;
 		std::optional<ndb::SubNodeBTree> m_subtree;
 		HN m_hn;
@@ -1178,7 +1476,7 @@ namespace storyt::ltp {
 	{
 	public:
 
-		explicit SingleRow(const std::vector<types::byte_t>& rowBytes, const TCInfo& header)
+		explicit SingleRow(std::span<const types::byte_t> rowBytes, const TCInfo& header)
 			: m_tcInfo(header)
 		{
 			const size_t offset4b = header.rgib.at(TCInfo::TCI_4b);
@@ -1193,8 +1491,8 @@ namespace storyt::ltp {
 			utils::ByteView view(rowBytes);
 			m_dwRowID = view.read<uint32_t>(4);
 			// Read everything from the start of Row Data to the start of rgbCEB
-			m_data = view.setStart(0).read(offset1b);
-			m_rgbCEB = view.read(totalRowSize - offset1b);
+			m_data = view.setStart(0).readView(offset1b);
+			m_rgbCEB = view.readView(totalRowSize - offset1b);
 			_setupRowEntries();
 			STORYT_ASSERT((m_rgbCEB.size() == static_cast<size_t>(std::ceil(static_cast<double>(header.cCols) / 8.0))), "RowData Constructor");
 		}
@@ -1256,14 +1554,15 @@ namespace storyt::ltp {
 					entry->propType = utils::PropertyType(colInfo.getPType());
 					const utils::PTInfo ptInfo = utils::PropertyTypeInfo(colInfo.getPType());
 					// Read data where the column starts (ibData) to where it ends (cbData)
-					const std::vector<types::byte_t> data = view.setStart(colInfo.ibData).read(colInfo.cbData);
+					const std::span<const types::byte_t> data = view.setStart(colInfo.ibData).readView(colInfo.cbData);
 					if (DataIsStoredInline(ptInfo)) // Data is stored inline
 					{
-						entry->data = data;
+						entry->data.assign(data.begin(), data.end());
 					}
 					else if (DataIsStoredInHN(data)) // Data is stored in HN and Indexed using HID
 					{
-						entry->data = hn.getAllocation(HID(data));
+						const std::span<const types::byte_t> alloc = hn.getAllocation(HID(data));
+						entry->data.assign(alloc.begin(), alloc.end());
 					}
 					else if (DataIsStoredInSubNodeTree(ptInfo, data) && subtree.has_value())
 					{
@@ -1300,12 +1599,12 @@ namespace storyt::ltp {
 			return ptInfo.isFixed && ptInfo.singleEntrySize <= 8ULL;
 		}
 
-		[[nodiscard]] bool DataIsStoredInHN(const std::vector<types::byte_t>& data) const
+		[[nodiscard]] bool DataIsStoredInHN(std::span<const types::byte_t> data) const
 		{
 			return (data[0] & 0x1FU) == 0U;
 		}
 
-		[[nodiscard]] bool DataIsStoredInSubNodeTree(const utils::PTInfo& ptInfo, const std::vector<types::byte_t>& data) const
+		[[nodiscard]] bool DataIsStoredInSubNodeTree(const utils::PTInfo& ptInfo, std::span<const types::byte_t> data) const
 		{
 			return !DataIsStoredInline(ptInfo) && !DataIsStoredInHN(data);
 		}
@@ -1352,11 +1651,12 @@ namespace storyt::ltp {
 		/// is "not set" or "invalid". In this case, the property MUST be "not found" if requested. 
 		/// The size of rgCEB is CEIL(TCINFO.cCols / 8) bytes. Extra lower-order bits SHOULD be ignored. 
 		/// Creators of a new PST MUST set the extra lower-order bits to zero.
-		std::vector<types::byte_t> m_rgbCEB{};
+		/// A view into the Row Matrix owned by the TC's HN or SubNodeBTree.
+		std::span<const types::byte_t> m_rgbCEB{};
 		/// Everything from the start of Row Data to the start of rgbCEB
 		/// Can contain the actual data is the data is less than 8 bytes
-		/// otherwise the data is in the single row.
-		std::vector<types::byte_t> m_data{};
+		/// otherwise the data is in the single row. A view into the Row Matrix like m_rgbCEB.
+		std::span<const types::byte_t> m_data{};
 		/// RowEntries will either be loaded or need to be loaded.
 		/// If loaded they will contain all the byte information for that particular
 		/// row entry. If not loaded they will need be loaded using an HN and SubNodeTree.
@@ -1368,7 +1668,7 @@ namespace storyt::ltp {
 	{
 
 	public:
-		RowBlock(const std::vector<types::byte_t>& blockBytes, const TCInfo& header, size_t rowsPerBlock)
+		RowBlock(std::span<const types::byte_t> blockBytes, const TCInfo& header, size_t rowsPerBlock)
 		{
 			const size_t singleRowSize = header.rgib.at(TCInfo::TCI_bm);
 			utils::ByteView view(blockBytes);
@@ -1457,6 +1757,16 @@ namespace storyt::ltp {
 			return m_rowIDs;
 		}
 
+		[[nodiscard]] const core::ReadOptions& readOptions() const
+		{
+			return m_hn.readOptions();
+		}
+
+		[[nodiscard]] bool shouldValidate(core::Validation level) const
+		{
+			return m_hn.shouldValidate(level);
+		}
+
 		[[nodiscard]] const std::vector<TColDesc>& getColumns() const
 		{
 			return m_header.rgTCOLDESC;
@@ -1505,7 +1815,7 @@ namespace storyt::ltp {
 			return m_rowBlocks.at(blockIdx).getSingleRow(rowIdx);
 		}
 
-		static TCInfo readTCInfo(const std::vector<types::byte_t>& bytes)
+		static TCInfo readTCInfo(std::span<const types::byte_t> bytes)
 		{
 			utils::ByteView view(bytes);
 			TCInfo info{};
@@ -1516,7 +1826,7 @@ namespace storyt::ltp {
 			info.hnidRows = view.entry<HNID>(4);
 			/// hidIndex is deprecated. Should be set to 0
 			info.hidIndex = view.read<uint32_t>(4);
-			info.rgTCOLDESC = readTColDesc(view.read(bytes.size() - 22ULL));
+			info.rgTCOLDESC = readTColDesc(view.readView(bytes.size() - 22ULL));
 
 			STORYT_ASSERT((info.bType == types::BType::TC), "Invalid BType");
 			STORYT_ASSERT((info.cCols == info.rgTCOLDESC.size()), "info.cCols != info.rgTCOLDESC.size()");
@@ -1528,22 +1838,21 @@ namespace storyt::ltp {
 			return info;
 		}
 
-		static std::vector<TColDesc> readTColDesc(const std::vector<types::byte_t>& bytes)
+		static std::vector<TColDesc> readTColDesc(std::span<const types::byte_t> bytes)
 		{
 			const size_t singleTColDescSize = 8;
 			STORYT_ASSERT((bytes.size() % singleTColDescSize == 0), "bytes.size() mod singleTColDescSize != 0");
 			std::vector<TColDesc> cols;
+			cols.reserve(bytes.size() / singleTColDescSize);
 
+			utils::ByteView view(bytes);
 			for (size_t i = 0; i < bytes.size() / singleTColDescSize; ++i)
 			{
-				const size_t start = i * singleTColDescSize;
-				const size_t end = start + singleTColDescSize;
-				const std::vector<types::byte_t> colBytes = utils::slice(bytes, start, end, singleTColDescSize);
 				TColDesc col{};
-				col.tag = utils::slice(colBytes, 0, 4, 4, utils::toT_l<uint32_t>);
-				col.ibData = utils::slice(colBytes, 4, 6, 2, utils::toT_l<uint16_t>);
-				col.cbData = utils::slice(colBytes, 6, 7, 1, utils::toT_l<uint8_t>);
-				col.iBit = utils::slice(colBytes, 7, 8, 1, utils::toT_l<uint8_t>);
+				col.tag = view.read<uint32_t>(4);
+				col.ibData = view.read<uint16_t>(2);
+				col.cbData = view.read<uint8_t>(1);
+				col.iBit = view.read<uint8_t>(1);
 				cols.push_back(col);
 			}
 			/// The entries in this array MUST be sorted by the tag field of TCOLDESC. In ascending order.
@@ -1563,7 +1872,10 @@ namespace storyt::ltp {
 			m_bth(m_hn, m_header.hidRowIndex), 
 			m_subtree(std::move(subtree))
 		{
-			VerifyTableContextIsValid_();
+			if (m_hn.shouldValidate(m_hn.readOptions().ltp))
+			{
+				VerifyTableContextIsValid_();
+			}
 			_loadRowIndexFromBTH();
 		}
 		void VerifyTableContextIsValid_() const
@@ -1576,7 +1888,7 @@ namespace storyt::ltp {
 		{
 			if (!m_bth.empty())
 			{
-				for (const auto& record : m_bth.records())
+				for (const auto& record : m_bth.records(m_hn))
 				{
 					m_rowIDs.push_back(record.as<TCRowID>());
 				}
@@ -1592,7 +1904,7 @@ namespace storyt::ltp {
 			auto rowBlockBytes = m_hn.getAllocation(m_header.hnidRows.as<HID>());
 			m_rowsPerBlock = rowBlockBytes.size() / getSizeOfSingleRow();
 			/// This check only works for HID allocated Row Matrices
-			STORYT_ASSERT((m_rowsPerBlock == m_bth.nrecords()), "Invalid number of rows per block");
+			STORYT_ASSERT((m_rowsPerBlock == m_bth.nrecords(m_hn)), "Invalid number of rows per block");
 			m_rowBlocks.emplace_back(rowBlockBytes, m_header, m_rowsPerBlock);
 		}
 
@@ -1617,13 +1929,13 @@ namespace storyt::ltp {
 					if (i == datatree->nDataBlocks() - 1)
 					{
 						m_rowBlocks.emplace_back(
-							datatree->at(i).data,
+							datatree->blockData(i),
 							m_header,
 							datatree->sizeOfDataBlockData(i) / m_header.rgib.at(TCInfo::TCI_bm)
 						);
 						continue;
 					}
-					m_rowBlocks.emplace_back(datatree->at(i).data, m_header, m_rowsPerBlock);
+					m_rowBlocks.emplace_back(datatree->blockData(i), m_header, m_rowsPerBlock);
 				}
 			}
 			else
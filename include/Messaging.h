@@ -8,6 +8,9 @@
 #include <unordered_map>
 #include <optional>
 #include <regex>
+#include <functional>
+#include <span>
+#include <string_view>
 
 #include "types.h"
 #include "utils.h"
@@ -26,7 +29,10 @@ namespace storyt
 		explicit Attachment(ltp::PropertyContext&& pc)
 			: m_pc(std::move(pc)) 
 		{
-			VerifyAttachmentPropertyContextIsValid_();
+			if (m_pc.shouldValidate(m_pc.readOptions().messaging))
+			{
+				VerifyAttachmentPropertyContextIsValid_();
+			}
 			STORYT_INFO("Attachment Mime Type Header [{}]", getMimeType());
 		}
 		[[nodiscard]] int32_t getSize()
@@ -71,7 +77,7 @@ namespace storyt
 				ltp::Property* data = m_pc.TryToGetProperty(types::PidTagType::AttachDataBinaryOrDataObject, types::PropertyType::Binary);
 				if (data)
 				{
-					return data->data;
+					return data->asPTBinary().data;
 				}
 			}
 			{
@@ -87,6 +93,23 @@ namespace storyt
 				"Attachments content PropType was not valid");
 			return {};
 		}
+		/**
+		 * @brief getContent without loading the content. Each chunk is read into buffer and passed to sink.
+		 * @return the size of the content in bytes.
+		*/
+		size_t streamContent(std::span<types::byte_t> buffer, const ltp::PropertyContext::Sink_t& sink)
+		{
+			if (m_pc.HasPropertyWPidAndPtypeOf(types::PidTagType::AttachDataBinaryOrDataObject, types::PropertyType::Binary))
+			{
+				return m_pc.StreamProperty(
+					static_cast<uint32_t>(types::PidTagType::AttachDataBinaryOrDataObject), types::PropertyType::Binary, buffer, sink);
+			}
+			STORYT_ASSERT(!m_pc.HasPropertyWPidAndPtypeOf(types::PidTagType::AttachDataBinaryOrDataObject, types::PropertyType::Object),
+				"Attachments with AttachDataObject set are nested Message Objects and they are not implemented currently");
+			STORYT_ASSERT(false, 
+				"Attachments content PropType was not valid");
+			return 0;
+		}
 	private:
 		void VerifyAttachmentPropertyContextIsValid_() const
 		{
@@ -124,7 +147,10 @@ namespace storyt
 		explicit AttachmentTable(ltp::TableContext&& tc, ndb::SubNodeBTree& messageObjectSubTree)
 			: m_tc(std::move(tc))
 		{
-			VerifyAttachmentTableIsValid_();
+			if (m_tc.shouldValidate(m_tc.readOptions().messaging))
+			{
+				VerifyAttachmentTableIsValid_();
+			}
 			_setupAttachments(messageObjectSubTree);
 		}
 		void VerifyAttachmentTableIsValid_() const
@@ -161,10 +187,38 @@ namespace storyt
 		std::vector<Attachment> m_attachments;
 	};
 
+	/**
+	 * @brief What opening a MessageObject reads. The message PC is always built but only the values of
+	 *  properties are loaded up front, everything else in it is read if and when it is asked for.
+	 *  The recipient TC and the attachment table are only built when they are asked for here.
+	 * 
+	 * @Note An indexer that only needs a few fields would use:
+	 *  Projection{ { PidTagTypeCombo::MessageSubject, PidTagTypeCombo::SenderEmailAddress, 
+	 *		PidTagTypeCombo::MessageDeliveryTime, PidTagTypeCombo::MessageSize } }
+	*/
+	struct Projection
+	{
+		/// Properties of the message PC that are loaded when the message is opened
+		std::vector<types::PidTagTypeCombo::Info> properties{};
+		bool recipients{ false };
+		bool attachments{ false };
+
+		/// Everything a MessageObject opened without a Projection reads
+		[[nodiscard]] static Projection All()
+		{
+			return Projection{ {}, true, true };
+		}
+	};
+
 	class MessageObject
 	{
 	public:
 		static MessageObject Init(core::NID nid, core::Ref<const ndb::NDB> ndb)
+		{
+			return Init(nid, ndb, Projection::All());
+		}
+
+		static MessageObject Init(core::NID nid, core::Ref<const ndb::NDB> ndb, const Projection& projection)
 		{
 			STORYT_ASSERT((nid.getNIDType() == types::NIDType::NORMAL_MESSAGE), 
 				"Invalid NIDType for Messsage Object [{}]", static_cast<uint32_t>(nid.getNIDType()));
@@ -184,11 +238,19 @@ namespace storyt
 				*/
 				ltp::PropertyContext pc = ltp::PropertyContext::Init(nbt->nid, ndb, messageSubNodeTree);
 				//STORYT_INFO(pc.getProperty(types::PidTagTypeCombo::MessageSubject.pid).asPTString().data.c_str());
-				std::optional<ltp::TableContext> recip = ltp::TableContext::Init(RECIPIENT_TC_NID, messageSubNodeTree);
-				std::optional<AttachmentTable> attachmentTable = AttachmentTable::Init(messageSubNodeTree);
+				for (const types::PidTagTypeCombo::Info info : projection.properties)
+				{
+					// Properties the message does not have are reported when they are asked for
+					static_cast<void>(pc.TryToGetProperty(info));
+				}
+				std::optional<ltp::TableContext> recip = projection.recipients ? 
+					ltp::TableContext::Init(RECIPIENT_TC_NID, messageSubNodeTree) : std::nullopt;
+				std::optional<AttachmentTable> attachmentTable = projection.attachments ? 
+					AttachmentTable::Init(messageSubNodeTree) : std::nullopt;
 
 				return MessageObject(
 					nid,
+					projection,
 					std::move(pc),
 					std::move(recip),
 					std::move(attachmentTable)
@@ -197,12 +259,15 @@ namespace storyt
 			else
 			{
 				STORYT_ERROR("Failed to construct message because NBTEntry could not be found with NID [{}]", nid.getNIDRaw());
-				return MessageObject(nid);
+				return MessageObject(nid, projection);
 			}
 		}
 
+		/// Only answers for a message opened with Projection::attachments, like getRecipients does for its recipients
 		[[nodiscard]] bool hasAttachments() const
 		{
+			STORYT_ASSERT(m_projection.attachments, 
+				"Message with NID [{}] was opened without its attachments in the Projection", m_nid.getNIDRaw());
 			return m_attachmentTable.has_value();
 		}
 
@@ -230,6 +295,8 @@ namespace storyt
 		[[nodiscard]] std::vector<std::string> getRecipients()
 		{
 			std::vector<std::string> emailAddresses{};
+			STORYT_ASSERT(m_projection.recipients, 
+				"Message with NID [{}] was opened without its recipients in the Projection", m_nid.getNIDRaw());
 			if (m_recip.has_value())
 			{
 				m_recip->loadRowMatrix(); // Make sure recip Row Matrix is loaded
@@ -280,20 +347,78 @@ namespace storyt
 			return {};
 		}
 
+		/// @return the FILETIME the message was delivered
+		[[nodiscard]] uint64_t getDeliveryTime()
+		{
+			ltp::Property* prop = TryToGetProperty_(types::PidTagTypeCombo::MessageDeliveryTime);
+			if (prop)
+			{
+				utils::ByteView view(prop->data());
+				return view.read<uint64_t>(8U);
+			}
+			STORYT_ASSERT(false, "Failed to getDeliveryTime for Message with NID [{}]", m_nid.getNIDRaw());
+			return 0;
+		}
+
+		[[nodiscard]] int32_t getSize()
+		{
+			ltp::Property* prop = TryToGetProperty_(types::PidTagTypeCombo::MessageSize);
+			if (prop)
+			{
+				return prop->asPTInt32();
+			}
+			STORYT_ASSERT(false, "Failed to getSize for Message with NID [{}]", m_nid.getNIDRaw());
+			return 0;
+		}
+
+		/**
+		 * @brief getBody without loading the body. The body is read into buffer a chunk at a time,
+		 *  converted the same way getBody converts it and passed to sink.
+		 * @return the number of characters in the body.
+		*/
+		size_t streamBody(std::span<types::byte_t> buffer, const std::function<void(std::string_view)>& sink)
+		{
+			for (const types::PidTagTypeCombo::Info info : { types::PidTagTypeCombo::MessageBody, types::PidTagTypeCombo::BodyHtml })
+			{
+				if (!m_pc.has_value() || !m_pc->HasPropertyWPidAndPtypeOf(info))
+				{
+					continue;
+				}
+				// Same as utils::UTF16BytesToString, the low byte of each UTF-16 code unit. A chunk can end 
+				// halfway through a code unit so the position is tracked across chunks.
+				size_t nBytes{ 0 };
+				std::string characters{};
+				m_pc->StreamProperty(info, buffer, [&](std::span<const types::byte_t> chunk) {
+					characters.clear();
+					for (size_t i = (nBytes % 2U); i < chunk.size(); i += 2)
+					{
+						characters.push_back(static_cast<char>(chunk[i]));
+					}
+					nBytes += chunk.size();
+					sink(characters);
+				});
+				return nBytes / 2U;
+			}
+			STORYT_ASSERT(false, "Failed to streamBody for Message with NID [{}]", m_nid.getNIDRaw());
+			return 0;
+		}
+
 	private:
-		explicit MessageObject(core::NID nid) : m_nid(nid)
+		explicit MessageObject(core::NID nid, const Projection& projection) : m_nid(nid), m_projection(projection)
 		{
 			_init();
 		}
 
 		explicit MessageObject(
 			core::NID nid, 
+			const Projection& projection,
 			std::optional<ltp::PropertyContext> pc,
 			std::optional<ltp::TableContext> recip,
 			std::optional<AttachmentTable> attachmentTable
 			)
 			: 
 			m_nid(nid), 
+			m_projection(projection),
 			m_pc(std::move(pc)), 
 			m_recip(std::move(recip)), 
 			m_attachmentTable(std::move(attachmentTable)) 
@@ -316,8 +441,15 @@ namespace storyt
 
 		void _init()
 		{
-			VerifyMessagePropertyContextIsValid_();
-			VerfiyMessageRecipientTableContextIsValid_();
+			// A message without a PC always fails its checks so there is nothing to skip.
+			if (!m_pc.has_value() || m_pc->shouldValidate(m_pc->readOptions().messaging))
+			{
+				VerifyMessagePropertyContextIsValid_();
+				if (m_projection.recipients)
+				{
+					VerfiyMessageRecipientTableContextIsValid_();
+				}
+			}
 		}
 
 		void VerifyMessagePropertyContextIsValid_() const
@@ -392,6 +524,7 @@ namespace storyt
 
 	private:
 		core::NID m_nid;
+		Projection m_projection;
 		std::optional<ltp::PropertyContext> m_pc;
 		std::optional<ltp::TableContext> m_recip;
 		std::optional<AttachmentTable> m_attachmentTable;
@@ -440,6 +573,14 @@ namespace storyt
 		}
 
 		[[nodiscard]] std::vector<MessageObject> getNMessages(size_t start, size_t end) const
+		{
+			return getNMessages(start, end, Projection::All());
+		}
+
+		/**
+		 * @brief Opens the messages in [start, end) reading only what projection asks for.
+		*/
+		[[nodiscard]] std::vector<MessageObject> getNMessages(size_t start, size_t end, const Projection& projection) const
 		{
 			/*
 			* The RowIndex (section 2.3.4.3) of the contents table TC provides an efficient mechanism to locate
@@ -456,7 +597,7 @@ namespace storyt
 			{
 				const ltp::TCRowID& rowid = rowIDs.at(i);
 				const core::NID rowNID(rowid.dwRowID);
-				messages.push_back(MessageObject::Init(rowNID, m_ndb));
+				messages.push_back(MessageObject::Init(rowNID, m_ndb, projection));
 			}
 			return messages;
 		}
@@ -468,6 +609,20 @@ namespace storyt
 			return m_contents.nRows();
 		}
 
+		/**
+		 * @brief The NIDs of the messages in this folder taken from the nidParent of each NBT entry.
+		 *  Unlike getNMessages() this does not open the contents table or any of the messages.
+		*/
+		[[nodiscard]] std::vector<core::NID> getMessageNIDs() const
+		{
+			return m_ndb->children(m_nid, types::NIDType::NORMAL_MESSAGE);
+		}
+
+		[[nodiscard]] std::vector<core::NID> getSubFolderNIDs() const
+		{
+			return m_ndb->children(m_nid, types::NIDType::NORMAL_FOLDER);
+		}
+
 		[[nodiscard]] const std::string& getName()
 		{
 			return m_folderName;
@@ -536,9 +691,12 @@ namespace storyt
 			m_contents(contents), 
 			m_assoc(assoc)
 		{
-			VerifyFolderNormalPropertContextIsValid_();
-			VerifyFolderHierarchyTableContextIsValid_();
-			VerifyFolderContentsTableContextIsValid_();
+			if (m_ndb->readOptions().shouldValidate(m_ndb->readOptions().messaging, m_nid.getNIDRaw()))
+			{
+				VerifyFolderNormalPropertContextIsValid_();
+				VerifyFolderHierarchyTableContextIsValid_();
+				VerifyFolderContentsTableContextIsValid_();
+			}
 			_setupFolderName();
 			_setupSubFolders();
 			//_setupMessages();
@@ -704,7 +862,7 @@ namespace storyt
 			{
 				return EntryID(
 					entryIDProp->asPTBinary().data,
-					entryRecordKeyProp->data
+					entryRecordKeyProp->asPTBinary().data
 				);
 			}
 			STORYT_ASSERT(false, "Failed to EntryID with PID of [{}]", static_cast<uint32_t>(pid));
@@ -716,7 +874,10 @@ namespace storyt
 		MessageStore(core::NID nid, core::Ref<const ndb::NDB> ndb, ltp::PropertyContext&& pc)
 			: m_nid(nid), m_ndb(ndb), m_pc(pc)
 		{
-			VerifyMessageStorePropertyContextIsValid_();
+			if (m_ndb->readOptions().shouldValidate(m_ndb->readOptions().messaging, m_nid.getNIDRaw()))
+			{
+				VerifyMessageStorePropertyContextIsValid_();
+			}
 	/*		STORYT_INFO("Message Store Display Name: [{}]",
 				as<ltp::PTString>(types::PidTagType::DisplayName).data);*/
 		}
@@ -7,12 +7,21 @@
 #include <utility>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <array>
 #include <optional>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <list>
+#include <deque>
+#include <algorithm>
 
 #include "types.h"
 #include "utils.h"
 #include "core.h"
+#include "io.h"
+#include "simd.h"
 
 #ifndef STORYT_NDB_H
 #define STORYT_NDB_H
@@ -37,7 +46,7 @@ namespace storyt::ndb {
         /// for other page types are allocated from the special bidNextP counter in the HEADER structure.
         core::BID bid{};
 
-        explicit PageTrailer(const std::vector<types::byte_t>& bytes, core::BREF bref)
+        explicit PageTrailer(std::span<const types::byte_t> bytes, core::BREF bref)
             : PageTrailer(bytes)
         {
             auto computedSig = utils::ms::ComputeSig(bref.ib, bref.bid.getBidRaw());
@@ -47,7 +56,7 @@ namespace storyt::ndb {
             }
         }
 
-        explicit PageTrailer(const std::vector<types::byte_t>& bytes)
+        explicit PageTrailer(std::span<const types::byte_t> bytes)
         {
             utils::ByteView view(bytes);
             ptype = utils::getPType(view.read<uint8_t>(1));
@@ -57,6 +66,14 @@ namespace storyt::ndb {
             bid = view.entry<core::BID>(8);
             STORYT_ASSERT((ptype == ptypeRepeat), "PageTrailer Constructor");
         }
+
+        /**
+         * @param validate = when false the signature is not computed or checked.
+        */
+        static PageTrailer Init(std::span<const types::byte_t> bytes, core::BREF bref, bool validate)
+        {
+            return validate ? PageTrailer(bytes, bref) : PageTrailer(bytes);
+        }
     };
 
     struct BlockTrailer
@@ -73,7 +90,7 @@ namespace storyt::ndb {
         /// (Unicode: 8 bytes; ANSI 4 bytes): The BID (section 2.2.2.2) of the data block.
         core::BID bid{};
 
-        explicit BlockTrailer(const std::vector<types::byte_t>& bytes, core::BREF bref)
+        explicit BlockTrailer(std::span<const types::byte_t> bytes, core::BREF bref)
             : BlockTrailer(bytes)
         {
             auto computedSig = utils::ms::ComputeSig(bref.ib, bref.bid.getBidRaw());
@@ -81,7 +98,7 @@ namespace storyt::ndb {
                 "[ERROR] Page Sig [{}] != Computed Sig [{}]", wSig, computedSig);
         }
 
-        explicit BlockTrailer(const std::vector<types::byte_t>& bytes)
+        explicit BlockTrailer(std::span<const types::byte_t> bytes)
         {
             STORYT_ASSERT((bytes.size() == 16), "Block Trailer has to be 16 bytes not [{}]", bytes.size());
             utils::ByteView view(bytes);
@@ -90,6 +107,14 @@ namespace storyt::ndb {
             dwCRC = view.read<uint32_t>(4);
             bid = view.entry<core::BID>(8);
         }
+
+        /**
+         * @param validate = when false the signature is not computed or checked.
+        */
+        static BlockTrailer Init(std::span<const types::byte_t> bytes, core::BREF bref, bool validate)
+        {
+            return validate ? BlockTrailer(bytes, bref) : BlockTrailer(bytes);
+        }
     };
 
     struct BTEntry
@@ -157,7 +182,7 @@ namespace storyt::ndb {
     public:
         static constexpr uint8_t EntryMaxSize = 32;
     public:
-        explicit Entry(const std::vector<types::byte_t>& data) 
+        explicit Entry(std::span<const types::byte_t> data) 
             : m_data(data) 
         {
             _init();
@@ -259,8 +284,10 @@ namespace storyt::ndb {
     {
     public:
         using GetBytes_t = std::function<std::vector<types::byte_t>(uint64_t position)>;
+        /// Returns the child page referenced by a BTEntry. Child pages are only read when a lookup
+        /// first reaches them so the caller decides where they are read from and how long they are kept.
+        using GetPage_t = std::function<std::shared_ptr<const BTPage>(const core::BREF& bref, int32_t parentCLevel)>;
     public:
-        std::vector<BTPage> subPages{};
         /// (Unicode: 488 bytes; ANSI: 496 bytes): Entries of the BTree array.
         /// The entries in the array depend on the value of the cLevel field. If cLevel is greater than 0,
         /// then each entry in the array is of type BTENTRY.If cLevel is 0, then each entry is either of type
@@ -288,21 +315,14 @@ namespace storyt::ndb {
         /// size in bytes
         static constexpr size_t size = 512;
 
-        static BTPage Init(const std::vector<types::byte_t>& bytes, core::BREF bref, std::ifstream& file, int32_t parentCLevel = -1)
-        {
-            STORYT_ASSERT((bytes.size() == BTPage::size), "BTPage size [{}] != bytes.size() [{}]", BTPage::size, bytes.size());
-            utils::ByteView view(bytes);
-            return { bytes, PageTrailer(view.takeLast(16), bref), file, parentCLevel };
-        }
-
-        static BTPage Init(const std::vector<types::byte_t>& bytes, core::BREF bref, int32_t parentCLevel = -1)
+        static BTPage Init(std::span<const types::byte_t> bytes, core::BREF bref, int32_t parentCLevel = -1, bool validate = true)
         {
             STORYT_ASSERT((bytes.size() == BTPage::size), "BTPage size [{}] != bytes.size() [{}]", BTPage::size, bytes.size());
             utils::ByteView view(bytes);
-            return { bytes, PageTrailer(view.takeLast(16), bref), parentCLevel };
+            return { bytes, PageTrailer::Init(view.takeLast(16), bref, validate), parentCLevel };
         }
 
-        static BTPage Init(const std::vector<types::byte_t>& bytes, int32_t parentCLevel = -1)
+        static BTPage Init(std::span<const types::byte_t> bytes, int32_t parentCLevel = -1)
         {
             STORYT_ASSERT((bytes.size() == BTPage::size), "BTPage size [{}] != bytes.size() [{}]", BTPage::size, bytes.size());
             utils::ByteView view(bytes);
@@ -310,28 +330,7 @@ namespace storyt::ndb {
         }
 
         BTPage(
-            const std::vector<types::byte_t>& bytes,
-            PageTrailer&& trailer_,
-            std::ifstream& file,
-            int32_t parentCLevel = -1
-        )
-            : trailer(trailer_)
-        {
-            setup(bytes, parentCLevel);
-            if (hasBTEntries())
-            {
-                for (const auto& entry : rgentries)
-                {
-                    const BTEntry bt = entry.asBTEntry();
-                    subPages.push_back(
-                        BTPage::Init(utils::readBytes(file, bt.bref.ib, BTPage::size), bt.bref, file, cLevel)
-                    );
-                }
-            }
-        }
-
-        BTPage(
-            const std::vector<types::byte_t>& bytes, 
+            std::span<const types::byte_t> bytes, 
             PageTrailer&& trailer_, 
             int32_t parentCLevel = -1)
             : trailer(trailer_)
@@ -339,7 +338,7 @@ namespace storyt::ndb {
             setup(bytes, parentCLevel);
         }
 
-        void setup(const std::vector<types::byte_t>& bytes, int32_t parentCLevel = -1)
+        void setup(std::span<const types::byte_t> bytes, int32_t parentCLevel = -1)
         {
             utils::ByteView view(bytes);
             view.skip(488); // skip entries for now
@@ -351,11 +350,20 @@ namespace storyt::ndb {
             dwPadding = view.read<uint32_t>(4);
             // reset to beginning of bytes to read the entries
             rgentries = view.setStart(0).entries<Entry>(nEntries, singleEntrySize);
+            // The keys are packed into their own array so get() can binary search them
+            // without pulling every 32 byte Entry into the cache.
+            m_keys.clear();
+            m_keys.reserve(rgentries.size());
+            for (const Entry& entry : rgentries)
+            {
+                m_keys.push_back(_entryKey(entry, trailer.ptype, cLevel));
+            }
 
             STORYT_ASSERT((trailer.ptype == types::PType::BBT || trailer.ptype == types::PType::NBT), "Invalid ptype for pagetrailer");
             STORYT_ASSERT((nEntries <= maxNEntries), "Invalid cEnt [{}]", nEntries);
             STORYT_ASSERT((dwPadding == 0), "dwPadding should be 0 not [{}]", dwPadding);
             STORYT_ASSERT((nEntries == rgentries.size()), "nEntries [{}] != rgentries.size() [{}]", nEntries, rgentries.size());
+            STORYT_ASSERT(std::is_sorted(m_keys.begin(), m_keys.end()), "BTPage entries are not sorted by key");
             if (parentCLevel != -1)
             {
                 STORYT_ASSERT((parentCLevel - 1 == cLevel),
@@ -363,14 +371,14 @@ namespace storyt::ndb {
             }
         }
 
-        [[nodiscard]] std::unordered_map<types::NIDType, NBTEntry> all(core::NID nid) const
+        [[nodiscard]] std::unordered_map<types::NIDType, NBTEntry> all(core::NID nid, const GetPage_t& getPage = nullptr) const
         {
             std::unordered_map<types::NIDType, NBTEntry> map{};
-            all_(nid, map);
+            all_(nid, map, getPage);
             return map;
         }
 
-        void all_(core::NID nid, std::unordered_map<types::NIDType, NBTEntry>& entries) const
+        void all_(core::NID nid, std::unordered_map<types::NIDType, NBTEntry>& entries, const GetPage_t& getPage) const
         {
             if (NBTEntry::id() == getEntryType())
             {
@@ -388,48 +396,69 @@ namespace storyt::ndb {
                 }
             }
 
-            for (const auto& page : subPages)
+            else if (BTEntry::id() == getEntryType())
+            {
+                STORYT_ASSERT((getPage != nullptr), "An intermediate BTPage needs a GetPage_t to reach its child pages");
+                for (const auto& entry : rgentries)
+                {
+                    getPage(entry.asBTEntry().bref, cLevel)->all_(nid, entries, getPage);
+                }
+            }
+        }
+
+        /**
+         * @brief Calls callback(const Entry&) for every leaf entry under this page in key order.
+        */
+        template<typename Callback>
+        void forEachLeafEntry(const GetPage_t& getPage, Callback&& callback) const
+        {
+            if (isLeafPage())
+            {
+                for (const Entry& entry : rgentries)
+                {
+                    callback(entry);
+                }
+                return;
+            }
+            STORYT_ASSERT((getPage != nullptr), "An intermediate BTPage needs a GetPage_t to reach its child pages");
+            for (const Entry& entry : rgentries)
             {
-                page.all_(nid, entries);
+                getPage(entry.asBTEntry().bref, cLevel)->forEachLeafEntry(getPage, callback);
             }
         }
 
         template<typename EntryType, typename EntryIDType>
-        [[nodiscard]] std::optional<EntryType> get(EntryIDType id) const
+        [[nodiscard]] std::optional<EntryType> get(EntryIDType id, const GetPage_t& getPage = nullptr) const
         {
+            uint64_t key{ 0 };
+            if constexpr (std::is_same_v<EntryIDType, core::NID>)
+            {
+                key = id.getNIDRaw();
+            }
+            else
+            {
+                key = id.getBidRaw();
+            }
+
             if (EntryType::id() == getEntryType())
             {
-                for (const auto& entry : rgentries)
+                const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+                if (it != m_keys.end() && *it == key)
                 {
-                    if constexpr (std::is_same_v<EntryIDType, core::NID>)
-                    {
-                        if (entry.getCachedNBTNID() == id)
-                        {
-                            return entry.asNBTEntry();
-                        }
-                    }
-                    else
-                    {
-                        if (entry.getCachedBBTBID() == id)
-                        {
-                            return entry.asBBTEntry();
-                        }
-                    }
+                    return rgentries[static_cast<size_t>(it - m_keys.begin())].as<EntryType>();
                 }
             }
             else if (BTEntry::id() == getEntryType())
             {
-                for (size_t i = 0; i < rgentries.size(); ++i)
+                STORYT_ASSERT((getPage != nullptr), "An intermediate BTPage needs a GetPage_t to reach its child pages");
+                // Each child page holds every key from its own btkey up to the next entry's btkey, so the
+                // only child that can hold the key is the last one whose btkey is <= key. Exactly one
+                // page is visited per level and a miss never backtracks.
+                const auto it = std::upper_bound(m_keys.begin(), m_keys.end(), key);
+                if (it != m_keys.begin())
                 {
-                    const uint64_t btkey = rgentries.at(i).getCachedBTKey();
-                    if (id > btkey || id == btkey)
-                    {
-                        std::optional<EntryType> ret = subPages.at(i).get<EntryType>(id);
-                        if (ret.has_value())
-                        {
-                            return ret;
-                        }
-                    }
+                    const size_t child = static_cast<size_t>(it - m_keys.begin()) - 1;
+                    return getPage(rgentries[child].asBTEntry().bref, cLevel)->get<EntryType>(id, getPage);
                 }
             }
             return std::nullopt;
@@ -509,15 +538,35 @@ namespace storyt::ndb {
 
         [[nodiscard]] bool verify() const
         {
-            _verify(*this);
-            for(const auto& page : subPages)
-            {
-                _verify(page);
-            }
-            return true;
+            return _verify(*this);
+        }
+
+        /**
+         * @brief An estimate of how many bytes this page holds on to once it has been parsed.
+        */
+        [[nodiscard]] size_t nBytesInMemory() const
+        {
+            return sizeof(BTPage) + (rgentries.capacity() * sizeof(Entry)) + (m_keys.capacity() * sizeof(uint64_t));
         }
 
         private:
+            /**
+             * @brief The key a lookup compares against. NBT leaf entries are keyed by their 4 byte NID,
+             *  BBT leaf entries by their BID and intermediate entries by their btkey.
+            */
+            static uint64_t _entryKey(const Entry& entry, types::PType ptype, uint8_t cLevel)
+            {
+                if (cLevel == 0 && ptype == types::PType::NBT)
+                {
+                    return entry.getCachedNBTNID().getNIDRaw();
+                }
+                else if (cLevel == 0 && ptype == types::PType::BBT)
+                {
+                    return entry.getCachedBBTBID().getBidRaw();
+                }
+                return entry.getCachedBTKey();
+            }
+
             [[nodiscard]] bool _verify(const BTPage& page) const
             {
                 const types::PType ptype = trailer.ptype;
@@ -525,249 +574,756 @@ namespace storyt::ndb {
                 STORYT_ASSERT((page.nEntries == page.rgentries.size()), "Subpage has different number of entries than cEnt.");
                 return true;
             }
+
+        private:
+            /// The search key of every entry in rgentries, in the same order.
+            std::vector<uint64_t> m_keys{};
     };
 
-    struct DataBlock
+    /**
+    * @brief A thread safe LRU cache of parsed NBT and BBT pages keyed by their file offset.
+    *  Pages are handed out as shared_ptrs so a page that is evicted while a lookup is still
+    *  walking it stays alive until that lookup is done.
+    */
+    class PageCache
     {
-        /// data (Variable): Raw data.
-        std::vector<types::byte_t> data{};
-        const BlockTrailer trailer;
-        /// Total Size of the Block including the padding and trailer.
-        const size_t sizeWPadding{ 0 };
-        
+    public:
+        using LoadPage_t = std::function<BTPage()>;
+        static constexpr size_t DefaultByteBudget = 16ULL * 1024ULL * 1024ULL;
 
-        static DataBlock Init(const std::vector<types::byte_t>& bytes, core::BREF bref)
+    public:
+        explicit PageCache(size_t byteBudget = DefaultByteBudget)
+            : m_byteBudget(byteBudget) {}
+        PageCache(const PageCache&) = delete;
+        PageCache& operator=(const PageCache&) = delete;
+
+        [[nodiscard]] std::shared_ptr<const BTPage> get(uint64_t ib, const LoadPage_t& load)
         {
-            STORYT_ASSERT(!bref.bid.isInternal(), "A Data Block can NOT be marked as Internal");
-            utils::ByteView view(bytes);
-            return DataBlock( bytes, BlockTrailer(view.takeLast(16), bref) );
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_pages.find(ib);
+                if (it != m_pages.end())
+                {
+                    m_lru.splice(m_lru.begin(), m_lru, it->second);
+                    return it->second->second;
+                }
+            }
+            // The read happens outside of the lock so other threads can keep hitting the cache.
+            std::shared_ptr<const BTPage> page = std::make_shared<const BTPage>(load());
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_pages.find(ib);
+            if (it != m_pages.end()) // Another thread loaded the same page first
+            {
+                m_lru.splice(m_lru.begin(), m_lru, it->second);
+                return it->second->second;
+            }
+            m_lru.emplace_front(ib, page);
+            m_pages[ib] = m_lru.begin();
+            m_nBytes += page->nBytesInMemory();
+            _evict();
+            return page;
         }
 
-        explicit DataBlock(const std::vector<types::byte_t>& bytes, BlockTrailer&& trailer_)
-            : trailer(trailer_), sizeWPadding(bytes.size())
+        [[nodiscard]] size_t nPages() const
         {
-            utils::ByteView view(bytes);
-            std::vector<types::byte_t> data = view.read(trailer.cb);
-            STORYT_ASSERT((data.size() == trailer.cb), "blockBytes.size() != trailer.cb");
-
-            const size_t dwCRC = utils::ms::ComputeCRC(0, data.data(), static_cast<uint32_t>(trailer.cb));
-            STORYT_ASSERT((trailer.dwCRC == dwCRC), "trailer.dwCRC != dwCRC");
-            // TODO: The data block is not always encrypted or could be encrypted with a different algorithm
-            utils::ms::CryptPermute(
-                data.data(),
-                static_cast<int>(data.size()),
-                utils::ms::DECODE_DATA
-            );
-            this->data = std::move(data);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_pages.size();
         }
-    };
-
-    /*
-    * @brief: XBLOCKs are used when the data associated with a node data that exceeds 8,176 bytes in size.
-        The XBLOCK expands the data that is associated with a node by using an array of BIDs that reference data
-        blocks that contain the data stream associated with the node. A BLOCKTRAILER is present at the end of an XBLOCK,
-        and the end of the BLOCKTRAILER MUST be aligned on a 64-byte boundary.
-    */
-    struct XBlock
-    {
-        /// btype (1 byte): Block type; MUST be set to 0x01 to indicate an XBLOCK or XXBLOCK.
-        uint8_t btype{};
-        /// cLevel (1 byte): MUST be set to 0x01 to indicate an XBLOCK.
-        uint8_t cLevel{};
-        /// cEnt (2 bytes): The count of BID entries in the XBLOCK.
-        uint16_t nBids{};
-        /// lcbTotal (4 bytes): Total count of bytes of all the external data stored in the data blocks referenced by XBLOCK.
-        uint32_t lcbTotal{};
-        /// rgbid (variable): Array of BIDs that reference data blocks. The size is equal to the number of
-        /// entries indicated by cEnt multiplied by the size of a BID(8 bytes for Unicode PST files).
-        std::vector<core::BID> rgbid{};
-        /// (variable, optional): This field is present if the total size of all of the other fields is not a multiple of 64.
-        /// The size of this field is the smallest number of bytes required to make the size of the XBLOCK a multiple of 64.
-        /// Implementations MUST ignore this field.
-        uint32_t rgbPadding{};
-        /// blockTrailer (ANSI: 12 bytes; Unicode: 16 bytes): A BLOCKTRAILER structure (section 2.2.2.8.1).
-        const BlockTrailer trailer;
 
-        static XBlock Init(const std::vector<types::byte_t>& bytes, core::BREF bref)
+        [[nodiscard]] size_t nBytes() const
         {
-            STORYT_ASSERT(bref.bid.isInternal(), "A XBlock can NOT be marked as Internal");
-            utils::ByteView view(bytes);
-            return XBlock( bytes, BlockTrailer(view.takeLast(16), bref) );
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_nBytes;
         }
 
-        explicit XBlock(const std::vector<types::byte_t>& bytes, BlockTrailer&& trailer_)
-            : trailer(trailer_)
+        [[nodiscard]] size_t byteBudget() const
         {
-            utils::ByteView view(bytes);
-            btype = view.read<uint8_t>(1);
-            cLevel = view.read<uint8_t>(1);
-            nBids = view.read<uint16_t>(2);
-            lcbTotal = view.read<uint32_t>(4);
-            rgbid = view.entries<core::BID>(nBids, 8);
+            return m_byteBudget;
+        }
 
-            STORYT_ASSERT((btype == 0x01), "btype for XBlock should be 0x01 not [{}]", btype);
-            STORYT_ASSERT((cLevel == 0x01), "cLevel for XBlock should be 0x01 not [{}]", cLevel);
-            STORYT_ASSERT((rgbid.size() == nBids), "rgbid.size() != nBids");
+    private:
+        void _evict()
+        {
+            // Always keep the most recently used page even if it alone is over budget.
+            while (m_nBytes > m_byteBudget && m_lru.size() > 1)
+            {
+                const auto& [ib, page] = m_lru.back();
+                m_nBytes -= page->nBytesInMemory();
+                m_pages.erase(ib);
+                m_lru.pop_back();
+            }
         }
+
+    private:
+        mutable std::mutex m_mutex;
+        size_t m_byteBudget{ DefaultByteBudget };
+        size_t m_nBytes{ 0 };
+        std::list<std::pair<uint64_t, std::shared_ptr<const BTPage>>> m_lru{};
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, std::shared_ptr<const BTPage>>>::iterator> m_pages{};
     };
 
     /**
-    * @brief The XXBLOCK further expands the data that is associated with a node by using an array of BIDs that reference XBLOCKs.
-        A BLOCKTRAILER is present at the end of an XXBLOCK, and the end of the BLOCKTRAILER MUST be aligned on a 64-byte boundary.
+    * @brief Branch free lower bound over a sorted array. The loop always runs log2(n) times
+    *  and the compare compiles to a conditional move so there is nothing to mispredict.
     */
-    class XXBlock
+    template<typename Key>
+    size_t lowerBound(const std::vector<Key>& keys, Key key)
+    {
+        if (keys.empty())
+        {
+            return 0;
+        }
+        const Key* base = keys.data();
+        size_t n = keys.size();
+        while (n > 1)
+        {
+            const size_t half = n / 2;
+            base = (base[half] < key) ? base + half : base;
+            n -= half;
+        }
+        return static_cast<size_t>(base - keys.data()) + static_cast<size_t>(*base < key);
+    }
+
+    /**
+    * @brief Every NBT leaf entry collapsed into sorted parallel arrays. The NID keys are packed
+    *  next to each other so a lookup only touches the cache lines of the keys it compares.
+    */
+    class NBTIndex
     {
     public:
-        /// btype (1 byte): Block type; MUST be set to 0x01 to indicate an XBLOCK or XXBLOCK.
-        uint8_t btype{};
-        /// cLevel (1 byte): MUST be set to 0x02 to indicate an XXBLOCK.
-        uint8_t cLevel{};
-        /// cEnt (2 bytes): The count of BID entries in the XXBLOCK.
-        uint16_t nBids{};
-        /// lcbTotal (4 bytes): Total count of bytes of all the external data stored in XBLOCKs under this XXBLOCK.
-        uint32_t lcbTotal{};
-        /// rgbid (variable): Array of BIDs that reference XBLOCKs. The size is equal to the number of entries indicated by cEnt
-        /// multiplied by the size of a BID(8 bytes for Unicode PST files).
-        std::vector<core::BID> rgbid{};
-        /// rgbPadding (variable, optional): This field is present if the total size of all of the other fields is not a multiple of 64.
-        /// The size of this field is the smallest number of bytes required to make the size of the XXBLOCK a multiple of 64.
-        /// Implementations MUST ignore this field.
-        int64_t rgbPadding{};
-        /// blockTrailer (Unicode: 16 bytes): A BLOCKTRAILER structure (section 2.2.2.8.1).
-        const BlockTrailer trailer;
+        static NBTIndex Init(const BTPage& root, const BTPage::GetPage_t& getPage)
+        {
+            STORYT_ASSERT((root.trailer.ptype == types::PType::NBT), "An NBTIndex can only be built from the NBT");
+            NBTIndex index{};
+            root.forEachLeafEntry(getPage, [&index](const Entry& entry) {
+                const NBTEntry nbt = entry.asNBTEntry();
+                index.m_nids.push_back(nbt.nid.getNIDRaw());
+                index.m_nidParents.push_back(nbt.nidParent.getNIDRaw());
+                index.m_bidData.push_back(nbt.bidData.getBidRaw());
+                index.m_bidSub.push_back(nbt.bidSub.getBidRaw());
+            });
+            index._shrink();
+            STORYT_ASSERT(std::is_sorted(index.m_nids.begin(), index.m_nids.end()), "NBT leaf entries are not sorted");
+            return index;
+        }
+
+        [[nodiscard]] std::optional<NBTEntry> get(core::NID nid) const
+        {
+            const size_t idx = lowerBound(m_nids, nid.getNIDRaw());
+            if (idx == m_nids.size() || m_nids[idx] != nid.getNIDRaw())
+            {
+                return std::nullopt;
+            }
+            return at(idx);
+        }
 
-        static XXBlock Init(const std::vector<types::byte_t>& bytes, core::BREF bref)
+        [[nodiscard]] NBTEntry at(size_t idx) const
         {
-            STORYT_ASSERT(bref.bid.isInternal(), "A XBlock can NOT be marked as Internal");
-            utils::ByteView view(bytes);
-            return XXBlock(bytes, BlockTrailer(view.takeLast(16), bref));
+            NBTEntry nbt{};
+            nbt.nid = core::NID(m_nids[idx]);
+            nbt.nidParent = core::NID(m_nidParents[idx]);
+            nbt.bidData = core::BID(m_bidData[idx]);
+            nbt.bidSub = core::BID(m_bidSub[idx]);
+            return nbt;
         }
 
-        explicit XXBlock(const std::vector<types::byte_t>& bytes, BlockTrailer&& trailer_)
-            : trailer(trailer_)
+        [[nodiscard]] size_t size() const
         {
-            utils::ByteView view(bytes);
-            btype = view.read<uint8_t>(1);
-            cLevel = view.read<uint8_t>(1);
-            nBids = view.read<uint16_t>(2);
-            lcbTotal = view.read<uint32_t>(4);
-            rgbid = view.entries<core::BID>(nBids, 8);
+            return m_nids.size();
+        }
 
-            STORYT_ASSERT((btype == 0x01), "btype for XXBlock should be 0x01 not [{}]", btype);
-            STORYT_ASSERT((cLevel == 0x02), "cLevel for XXBlock should be 0x02 not [{}]", cLevel);
-            STORYT_ASSERT((rgbid.size() == nBids), "rgbid.size() != nBids");
+        [[nodiscard]] size_t nBytesInMemory() const
+        {
+            return sizeof(NBTIndex) + m_nids.capacity() * sizeof(uint32_t) + m_nidParents.capacity() * sizeof(uint32_t)
+                + m_bidData.capacity() * sizeof(uint64_t) + m_bidSub.capacity() * sizeof(uint64_t);
+        }
+
+    private:
+        void _shrink()
+        {
+            m_nids.shrink_to_fit();
+            m_nidParents.shrink_to_fit();
+            m_bidData.shrink_to_fit();
+            m_bidSub.shrink_to_fit();
         }
+
+    private:
+        std::vector<uint32_t> m_nids{};
+        std::vector<uint32_t> m_nidParents{};
+        std::vector<uint64_t> m_bidData{};
+        std::vector<uint64_t> m_bidSub{};
     };
 
-    class DataTree
+    /**
+    * @brief Every BBT leaf entry collapsed into sorted parallel arrays.
+    */
+    class BBTIndex
     {
     public:
-        using GetBBT_t = std::function<std::optional<BBTEntry>(const core::BID& bid)>;
+        static BBTIndex Init(const BTPage& root, const BTPage::GetPage_t& getPage)
+        {
+            STORYT_ASSERT((root.trailer.ptype == types::PType::BBT), "A BBTIndex can only be built from the BBT");
+            BBTIndex index{};
+            root.forEachLeafEntry(getPage, [&index](const Entry& entry) {
+                const BBTEntry bbt = entry.asBBTEntry();
+                index.m_bids.push_back(bbt.bref.bid.getBidRaw());
+                index.m_ibs.push_back(bbt.bref.ib);
+                index.m_cbs.push_back(bbt.cb);
+                index.m_cRefs.push_back(bbt.cRef);
+            });
+            index._shrink();
+            STORYT_ASSERT(std::is_sorted(index.m_bids.begin(), index.m_bids.end()), "BBT leaf entries are not sorted");
+            return index;
+        }
+
+        [[nodiscard]] std::optional<BBTEntry> get(core::BID bid) const
+        {
+            const size_t idx = lowerBound(m_bids, bid.getBidRaw());
+            if (idx == m_bids.size() || m_bids[idx] != bid.getBidRaw())
+            {
+                return std::nullopt;
+            }
+            return at(idx);
+        }
 
-    public:
-        DataTree(core::Ref<std::ifstream> file, const GetBBT_t& getBBT, core::BREF bref, size_t sizeOfBlockData)
-            : m_file(file), m_firstBlockBREF(bref), m_getBBT(getBBT), m_sizeofFirstBlockData(sizeOfBlockData)
+        [[nodiscard]] BBTEntry at(size_t idx) const
         {
-            static_assert(std::is_move_constructible_v<DataTree>, "DataTree must be move constructible");
-            static_assert(std::is_move_assignable_v<DataTree>, "DataTree must be move assignable");
-            static_assert(std::is_copy_constructible_v<DataTree>, "DataTree must be copy constructible");
-            static_assert(std::is_copy_assignable_v<DataTree>, "DataTree must be copy assignable");
+            BBTEntry bbt{};
+            bbt.bref = core::BREF(m_bids[idx], m_ibs[idx]);
+            bbt.cb = m_cbs[idx];
+            bbt.cRef = m_cRefs[idx];
+            return bbt;
         }
 
-        [[nodiscard]] size_t nDataBlocks() const
+        [[nodiscard]] size_t size() const
         {
-            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
-            return m_dataBlocks.size();
+            return m_bids.size();
         }
 
-        [[nodiscard]] size_t sizeOfDataBlockData(size_t dataBlockIdx) const
+        [[nodiscard]] size_t nBytesInMemory() const
         {
-            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
-            return m_dataBlocks.at(dataBlockIdx).data.size();
+            return sizeof(BBTIndex) + m_bids.capacity() * sizeof(uint64_t) + m_ibs.capacity() * sizeof(uint64_t)
+                + m_cbs.capacity() * sizeof(uint16_t) + m_cRefs.capacity() * sizeof(uint16_t);
         }
 
-        [[nodiscard]] const DataBlock& at(size_t idx) const
+    private:
+        void _shrink()
         {
-            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
-            return m_dataBlocks.at(idx);
+            m_bids.shrink_to_fit();
+            m_ibs.shrink_to_fit();
+            m_cbs.shrink_to_fit();
+            m_cRefs.shrink_to_fit();
+        }
+
+    private:
+        std::vector<uint64_t> m_bids{};
+        std::vector<uint64_t> m_ibs{};
+        std::vector<uint16_t> m_cbs{};
+        std::vector<uint16_t> m_cRefs{};
+    };
+
+    struct DataBlock
+    {
+        const BlockTrailer trailer;
+        /// Total Size of the Block including the padding and trailer.
+        const size_t sizeWPadding{ 0 };
+
+        /**
+         * @param bytes = the whole block including the padding and trailer. When bytes are borrowed they
+         *  must outlive the DataBlock, which is true of any read from a memory mapped BlockSource.
+         * @param cryptMethod = the bCryptMethod from the header that every data block is encoded with.
+         * @param validate = when false neither the signature nor the CRC is computed or checked.
+        */
+        static DataBlock Init(
+            io::Bytes&& bytes, 
+            core::BREF bref, 
+            types::CryptMethod cryptMethod = types::CryptMethod::PERMUTE, 
+            bool validate = true
+        )
+        {
+            STORYT_ASSERT(!bref.bid.isInternal(), "A Data Block can NOT be marked as Internal");
+            utils::ByteView view(bytes.view());
+            BlockTrailer trailer = BlockTrailer::Init(view.takeLast(16), bref, validate);
+            return DataBlock(std::move(bytes), std::move(trailer), cryptMethod, validate);
         }
 
-        [[nodiscard]] std::vector<types::byte_t> combineDataBlocks()
+        explicit DataBlock(
+            io::Bytes&& bytes, 
+            BlockTrailer&& trailer_, 
+            types::CryptMethod cryptMethod = types::CryptMethod::PERMUTE, 
+            bool validate = true
+        )
+            : trailer(trailer_), sizeWPadding(bytes.size())
         {
-            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
-            const size_t maxBlockSize = 8192U;
-            std::vector<types::byte_t> res;
-            res.reserve(nDataBlocks() * maxBlockSize);
-            for (const auto& block : m_dataBlocks)
+            if (validate)
             {
-                for (auto byte : block.data)
-                {
-                    res.push_back(byte);
-                }
+                const std::span<const types::byte_t> raw = utils::ByteView(bytes.view()).readView(trailer.cb);
+                const uint32_t dwCRC = simd::ComputeCRC(0, raw);
+                STORYT_ASSERT((trailer.dwCRC == dwCRC), "trailer.dwCRC != dwCRC");
+            }
+
+            if (cryptMethod == types::CryptMethod::NONE)
+            {
+                // Nothing to decode so the block keeps the bytes it was given. For a memory mapped
+                // file this is a view straight into the mapping and nothing is ever copied.
+                m_bytes = std::move(bytes);
+                return;
             }
-            return res;
+            // Owned bytes are decoded in place, borrowed bytes are copied once into the decode buffer.
+            std::vector<types::byte_t> data = std::move(bytes).toVector();
+            data.resize(trailer.cb);
+            Decrypt(data, cryptMethod, trailer.bid);
+            m_bytes = io::Bytes(std::move(data));
         }
 
-        auto begin()
+        /**
+         * @brief A block whose data was already decoded somewhere else, e.g. by DecodeInto. data is viewed, not copied,
+         *  but still counts towards nBytesInMemory because whoever owns data keeps it alive for as long as this block is.
+        */
+        static DataBlock View(std::span<const types::byte_t> data, const BlockTrailer& trailer_)
         {
-            load();
-            return m_dataBlocks.begin();
+            DataBlock block(io::Bytes(data), BlockTrailer(trailer_), types::CryptMethod::NONE, false);
+            block.m_isChargedForView = true;
+            return block;
         }
-        auto end()
+
+        /**
+         * @brief Checks and decodes a whole block straight into out without constructing a DataBlock.
+         * @param blockBytes = the whole block including the padding and trailer.
+         * @param out = where the decoded data goes. Must be exactly trailer.cb bytes.
+         * @throws std::runtime_error when the trailer's cb, which comes from the file, does not match out or the block.
+         * @return the block's trailer.
+        */
+        static BlockTrailer DecodeInto(
+            std::span<const types::byte_t> blockBytes, 
+            core::BREF bref, 
+            types::CryptMethod cryptMethod, 
+            bool validate, 
+            std::span<types::byte_t> out
+        )
         {
-            return m_dataBlocks.end();
+            STORYT_ASSERT(!bref.bid.isInternal(), "A Data Block can NOT be marked as Internal");
+            utils::ByteView view(blockBytes);
+            const BlockTrailer trailer = BlockTrailer::Init(view.takeLast(16), bref, validate);
+            // out is sized from the BBT so a corrupt trailer would otherwise write past it
+            STORYT_VERIFY((trailer.cb == out.size() && trailer.cb + 16U <= blockBytes.size()));
+            const std::span<const types::byte_t> raw = blockBytes.first(trailer.cb);
+            if (validate)
+            {
+                const uint32_t dwCRC = simd::ComputeCRC(0, raw);
+                STORYT_ASSERT((trailer.dwCRC == dwCRC), "trailer.dwCRC != dwCRC");
+            }
+            std::copy(raw.begin(), raw.end(), out.begin());
+            Decrypt(out, cryptMethod, trailer.bid);
+            return trailer;
         }
 
-        DataTree& load() // A DataTree's Datablocks are only loaded into memory after the first access
+        /**
+         * @brief Decodes data in place with the block's bCryptMethod.
+        */
+        static void Decrypt(std::span<types::byte_t> data, types::CryptMethod cryptMethod, core::BID bid)
         {
-            if (m_DataBlocksAreSetup)
+            switch (cryptMethod)
             {
-                return *this;
+            case types::CryptMethod::NONE:
+                break;
+            case types::CryptMethod::PERMUTE:
+                simd::CryptPermute(data, false);
+                break;
+            case types::CryptMethod::CYCLIC:
+                // The key is the lower DWORD of the block's BID.
+                simd::CryptCyclic(data, static_cast<uint32_t>(bid.getBidRaw()));
+                break;
+            default:
+                STORYT_ASSERT(false, "Unsupported bCryptMethod [{}]", static_cast<uint32_t>(cryptMethod));
             }
-            const auto [blockSize, offset] = calcBlockAlignedSize(m_sizeofFirstBlockData);
-            const size_t blockTrailerSize = 16U;
+        }
 
-            std::vector<types::byte_t> blockBytes = _readBlockBytes(m_firstBlockBREF.ib, blockSize);
-            utils::ByteView view(blockBytes);
-            BlockTrailer trailer(view.takeLast(blockTrailerSize), m_firstBlockBREF);
+        /**
+         * @brief The decoded data of the block without the padding and trailer.
+        */
+        [[nodiscard]] std::span<const types::byte_t> data() const
+        {
+            return m_bytes.view().first(trailer.cb);
+        }
 
-            STORYT_ASSERT((trailer.bid == m_firstBlockBREF.bid), 
-                "Bids should match");
-            STORYT_ASSERT((blockSize - (blockTrailerSize + offset) == trailer.cb),
-                "Given BlockSize [{}] != Trailer BlockSize [{}]", blockSize, trailer.cb);
-            STORYT_ASSERT((m_sizeofFirstBlockData == trailer.cb),
-                "Given sizeofBlockData [{}] != Trailer BlockSize [{}]", m_sizeofFirstBlockData, trailer.cb);
+        [[nodiscard]] std::vector<types::byte_t> toVector() &&
+        {
+            std::vector<types::byte_t> ret = std::move(m_bytes).toVector();
+            ret.resize(trailer.cb);
+            return ret;
+        }
+
+        [[nodiscard]] size_t nBytesInMemory() const
+        {
+            return sizeof(DataBlock) + ((m_bytes.isOwned() || m_isChargedForView) ? m_bytes.size() : 0);
+        }
+
+    private:
+        io::Bytes m_bytes{};
+        bool m_isChargedForView{ false };
+    };
+
+    /**
+    * @brief Decoded DataBlocks shared between every DataTree of an NDB and keyed by BID. A hit skips the read,
+    *  the CRC check and the decode. The BIDs are spread over independently locked shards, each with an
+    *  equal slice of the byte budget and its own least recently used eviction, so threads loading different
+    *  blocks rarely wait on each other.
+    */
+    class BlockCache
+    {
+    public:
+        static constexpr size_t DefaultByteBudget = 32ULL * 1024ULL * 1024ULL;
+        static constexpr size_t NShards = 16;
+
+    public:
+        explicit BlockCache(size_t byteBudget = DefaultByteBudget)
+            : m_byteBudget(byteBudget) {}
+        BlockCache(const BlockCache&) = delete;
+        BlockCache& operator=(const BlockCache&) = delete;
 
-            if (!trailer.bid.isInternal()) // Data Block
+        [[nodiscard]] std::shared_ptr<const DataBlock> find(core::BID bid)
+        {
+            Shard& shard = _shard(bid);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.blocks.find(bid.getBidRaw());
+            if (it == shard.blocks.end())
             {
-                m_dataBlocks.push_back(DataBlock::Init(blockBytes, m_firstBlockBREF)); // If the first block is a data block then we are done.
+                return nullptr;
             }
-            else if (trailer.bid.isInternal()) // the block internal
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->second;
+        }
+
+        /**
+         * @return The cached block, which is the one passed in unless another thread inserted the same BID first.
+        */
+        std::shared_ptr<const DataBlock> insert(core::BID bid, std::shared_ptr<const DataBlock> block)
+        {
+            Shard& shard = _shard(bid);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.blocks.find(bid.getBidRaw());
+            if (it != shard.blocks.end())
             {
-                const auto btype = utils::slice(blockBytes, 0, 1, 1, utils::toT_l<uint32_t>);
-                if (btype == 0x01U) // XBlock
-                {
-                    _xBlocktoDataBlocks(XBlock::Init(blockBytes, m_firstBlockBREF));
-                }
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                return it->second->second;
+            }
+            shard.lru.emplace_front(bid.getBidRaw(), block);
+            shard.blocks[bid.getBidRaw()] = shard.lru.begin();
+            shard.nBytes += block->nBytesInMemory();
+            _evict(shard);
+            return block;
+        }
 
-                else if (btype == 0x02U) // XXBlock
-                {
-                    _xxBlocktoDataBlocks(XXBlock::Init(blockBytes, m_firstBlockBREF));
-                }
-                else
+        [[nodiscard]] size_t nBlocks() const
+        {
+            size_t n{ 0 };
+            for (const Shard& shard : m_shards)
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                n += shard.blocks.size();
+            }
+            return n;
+        }
+
+        [[nodiscard]] size_t nBytes() const
+        {
+            size_t n{ 0 };
+            for (const Shard& shard : m_shards)
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                n += shard.nBytes;
+            }
+            return n;
+        }
+
+        [[nodiscard]] size_t byteBudget() const
+        {
+            return m_byteBudget;
+        }
+
+    private:
+        using LRU_t = std::list<std::pair<uint64_t, std::shared_ptr<const DataBlock>>>;
+        struct Shard
+        {
+            mutable std::mutex mutex;
+            size_t nBytes{ 0 };
+            LRU_t lru{};
+            std::unordered_map<uint64_t, LRU_t::iterator> blocks{};
+        };
+
+        Shard& _shard(core::BID bid)
+        {
+            // The bottom 2 bits of a BID are flags and BIDs are handed out in increments of 4.
+            return m_shards[(bid.getBidRaw() >> 2U) % NShards];
+        }
+
+        void _evict(Shard& shard)
+        {
+            // Always keep the most recently used block even if it alone is over budget.
+            const size_t shardBudget = m_byteBudget / NShards;
+            while (shard.nBytes > shardBudget && shard.lru.size() > 1)
+            {
+                const auto& [bid, block] = shard.lru.back();
+                shard.nBytes -= block->nBytesInMemory();
+                shard.blocks.erase(bid);
+                shard.lru.pop_back();
+            }
+        }
+
+    private:
+        size_t m_byteBudget{ DefaultByteBudget };
+        std::array<Shard, NShards> m_shards{};
+    };
+
+    /*
+    * @brief: XBLOCKs are used when the data associated with a node data that exceeds 8,176 bytes in size.
+        The XBLOCK expands the data that is associated with a node by using an array of BIDs that reference data
+        blocks that contain the data stream associated with the node. A BLOCKTRAILER is present at the end of an XBLOCK,
+        and the end of the BLOCKTRAILER MUST be aligned on a 64-byte boundary.
+    */
+    struct XBlock
+    {
+        /// btype (1 byte): Block type; MUST be set to 0x01 to indicate an XBLOCK or XXBLOCK.
+        uint8_t btype{};
+        /// cLevel (1 byte): MUST be set to 0x01 to indicate an XBLOCK.
+        uint8_t cLevel{};
+        /// cEnt (2 bytes): The count of BID entries in the XBLOCK.
+        uint16_t nBids{};
+        /// lcbTotal (4 bytes): Total count of bytes of all the external data stored in the data blocks referenced by XBLOCK.
+        uint32_t lcbTotal{};
+        /// rgbid (variable): Array of BIDs that reference data blocks. The size is equal to the number of
+        /// entries indicated by cEnt multiplied by the size of a BID(8 bytes for Unicode PST files).
+        std::vector<core::BID> rgbid{};
+        /// (variable, optional): This field is present if the total size of all of the other fields is not a multiple of 64.
+        /// The size of this field is the smallest number of bytes required to make the size of the XBLOCK a multiple of 64.
+        /// Implementations MUST ignore this field.
+        uint32_t rgbPadding{};
+        /// blockTrailer (ANSI: 12 bytes; Unicode: 16 bytes): A BLOCKTRAILER structure (section 2.2.2.8.1).
+        const BlockTrailer trailer;
+
+        static XBlock Init(std::span<const types::byte_t> bytes, core::BREF bref, bool validate = true)
+        {
+            STORYT_ASSERT(bref.bid.isInternal(), "A XBlock can NOT be marked as Internal");
+            utils::ByteView view(bytes);
+            return XBlock(bytes, BlockTrailer::Init(view.takeLast(16), bref, validate));
+        }
+
+        explicit XBlock(std::span<const types::byte_t> bytes, BlockTrailer&& trailer_)
+            : trailer(trailer_)
+        {
+            utils::ByteView view(bytes);
+            btype = view.read<uint8_t>(1);
+            cLevel = view.read<uint8_t>(1);
+            nBids = view.read<uint16_t>(2);
+            lcbTotal = view.read<uint32_t>(4);
+            rgbid = view.entries<core::BID>(nBids, 8);
+
+            STORYT_ASSERT((btype == 0x01), "btype for XBlock should be 0x01 not [{}]", btype);
+            STORYT_ASSERT((cLevel == 0x01), "cLevel for XBlock should be 0x01 not [{}]", cLevel);
+            STORYT_ASSERT((rgbid.size() == nBids), "rgbid.size() != nBids");
+        }
+    };
+
+    /**
+    * @brief The XXBLOCK further expands the data that is associated with a node by using an array of BIDs that reference XBLOCKs.
+        A BLOCKTRAILER is present at the end of an XXBLOCK, and the end of the BLOCKTRAILER MUST be aligned on a 64-byte boundary.
+    */
+    class XXBlock
+    {
+    public:
+        /// btype (1 byte): Block type; MUST be set to 0x01 to indicate an XBLOCK or XXBLOCK.
+        uint8_t btype{};
+        /// cLevel (1 byte): MUST be set to 0x02 to indicate an XXBLOCK.
+        uint8_t cLevel{};
+        /// cEnt (2 bytes): The count of BID entries in the XXBLOCK.
+        uint16_t nBids{};
+        /// lcbTotal (4 bytes): Total count of bytes of all the external data stored in XBLOCKs under this XXBLOCK.
+        uint32_t lcbTotal{};
+        /// rgbid (variable): Array of BIDs that reference XBLOCKs. The size is equal to the number of entries indicated by cEnt
+        /// multiplied by the size of a BID(8 bytes for Unicode PST files).
+        std::vector<core::BID> rgbid{};
+        /// rgbPadding (variable, optional): This field is present if the total size of all of the other fields is not a multiple of 64.
+        /// The size of this field is the smallest number of bytes required to make the size of the XXBLOCK a multiple of 64.
+        /// Implementations MUST ignore this field.
+        int64_t rgbPadding{};
+        /// blockTrailer (Unicode: 16 bytes): A BLOCKTRAILER structure (section 2.2.2.8.1).
+        const BlockTrailer trailer;
+
+        static XXBlock Init(std::span<const types::byte_t> bytes, core::BREF bref, bool validate = true)
+        {
+            STORYT_ASSERT(bref.bid.isInternal(), "A XBlock can NOT be marked as Internal");
+            utils::ByteView view(bytes);
+            return XXBlock(bytes, BlockTrailer::Init(view.takeLast(16), bref, validate));
+        }
+
+        explicit XXBlock(std::span<const types::byte_t> bytes, BlockTrailer&& trailer_)
+            : trailer(trailer_)
+        {
+            utils::ByteView view(bytes);
+            btype = view.read<uint8_t>(1);
+            cLevel = view.read<uint8_t>(1);
+            nBids = view.read<uint16_t>(2);
+            lcbTotal = view.read<uint32_t>(4);
+            rgbid = view.entries<core::BID>(nBids, 8);
+
+            STORYT_ASSERT((btype == 0x01), "btype for XXBlock should be 0x01 not [{}]", btype);
+            STORYT_ASSERT((cLevel == 0x02), "cLevel for XXBlock should be 0x02 not [{}]", cLevel);
+            STORYT_ASSERT((rgbid.size() == nBids), "rgbid.size() != nBids");
+        }
+    };
+
+    class DataTree
+    {
+    public:
+        using GetBBT_t = std::function<std::optional<BBTEntry>(const core::BID& bid)>;
+
+    public:
+        DataTree(
+            core::Ref<const io::BlockSource> source, 
+            const GetBBT_t& getBBT, 
+            core::BREF bref, 
+            size_t sizeOfBlockData, 
+            types::CryptMethod cryptMethod = types::CryptMethod::PERMUTE,
+            core::ReadOptions options = {},
+            BlockCache* blockCache = nullptr
+        )
+            : 
+            m_source(source), 
+            m_firstBlockBREF(bref), 
+            m_getBBT(getBBT), 
+            m_sizeofFirstBlockData(sizeOfBlockData), 
+            m_cryptMethod(cryptMethod), 
+            m_options(options),
+            m_blockCache(blockCache)
+        {
+            static_assert(std::is_move_constructible_v<DataTree>, "DataTree must be move constructible");
+            static_assert(std::is_move_assignable_v<DataTree>, "DataTree must be move assignable");
+            static_assert(std::is_copy_constructible_v<DataTree>, "DataTree must be copy constructible");
+            static_assert(std::is_copy_assignable_v<DataTree>, "DataTree must be copy assignable");
+        }
+
+        [[nodiscard]] size_t nDataBlocks() const
+        {
+            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
+            return m_dataOffsets.size() - 1;
+        }
+
+        [[nodiscard]] size_t sizeOfDataBlockData(size_t dataBlockIdx) const
+        {
+            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
+            return m_dataOffsets.at(dataBlockIdx + 1) - m_dataOffsets.at(dataBlockIdx);
+        }
+
+        /**
+         * @brief The decoded data of one data block. The view stays valid for as long as any copy of this DataTree is alive.
+        */
+        [[nodiscard]] std::span<const types::byte_t> blockData(size_t dataBlockIdx) const
+        {
+            return m_data.subspan(m_dataOffsets.at(dataBlockIdx), sizeOfDataBlockData(dataBlockIdx));
+        }
+
+        /**
+         * @brief The decoded data of every data block back to back. The view stays valid for as long as any copy of this DataTree is alive.
+        */
+        [[nodiscard]] std::span<const types::byte_t> data() const
+        {
+            STORYT_ASSERT(m_DataBlocksAreSetup, "The DataTree has NOT loaded its DataBlocks");
+            return m_data;
+        }
+
+        [[nodiscard]] std::vector<types::byte_t> combineDataBlocks() const
+        {
+            const std::span<const types::byte_t> all = data();
+            return std::vector<types::byte_t>(all.begin(), all.end());
+        }
+
+        [[nodiscard]] const core::ReadOptions& readOptions() const
+        {
+            return m_options;
+        }
+
+        /**
+         * @brief Whether level picks this DataTree to be checked. Samples are keyed by the BID of the first block.
+        */
+        [[nodiscard]] bool shouldValidate(core::Validation level) const
+        {
+            return m_options.shouldValidate(level, m_firstBlockBREF.bid.getBidRaw());
+        }
+
+        DataTree& load() // A DataTree's Datablocks are only loaded into memory after the first access
+        {
+            if (m_DataBlocksAreSetup)
+            {
+                return *this;
+            }
+            _loadLayout();
+            if (!m_firstBlockBREF.bid.isInternal()) // Data Block
+            {
+                // The data is a view into the block itself so a single block DataTree never copies its data.
+                std::shared_ptr<const DataBlock> block = _findCached(m_firstBlockBREF.bid);
+                if (block == nullptr)
                 {
-                    STORYT_ASSERT(false, "Invalid btype must 0x01 or 0x02 not [{}]", btype);
+                    block = _decode(_readFirstBlockBytes(), m_firstBlockBREF);
                 }
-                _flush(); // only flush when there are X or XX Blocks
+                m_data = block->data();
+                m_dataOwner = std::move(block);
             }
-            else // Invalid Block Type
+            else // X or XX Block
             {
-                STORYT_ASSERT(false, "Unknown block type");
+                _flush(); // only flush when there are X or XX Blocks
             }
             m_DataBlocksAreSetup = true;
             return *this;
         }
 
+        /**
+         * @brief The number of bytes of data across every data block. Only the X/XX blocks are read to find it.
+        */
+        [[nodiscard]] size_t sizeOfData()
+        {
+            _loadLayout();
+            return m_dataOffsets.back();
+        }
+
+        /**
+         * @brief Copies bytes [offset, offset + out.size()) of the data into out. Only the X/XX blocks and the data blocks
+         *  that overlap the range are read, unless the DataTree is already loaded in which case nothing is read.
+         * @return the number of bytes copied. Less than out.size() when the range runs past the end of the data.
+        */
+        size_t readRange(size_t offset, std::span<types::byte_t> out)
+        {
+            _loadLayout();
+            const size_t end = std::min(offset + out.size(), m_dataOffsets.back());
+            if (offset >= end)
+            {
+                return 0;
+            }
+            // m_dataOffsets[i] is where block i starts so the first block is the last one starting at or before offset.
+            const size_t first = static_cast<size_t>(std::upper_bound(m_dataOffsets.begin(), m_dataOffsets.end(), offset) - m_dataOffsets.begin()) - 1;
+            const size_t last = static_cast<size_t>(std::lower_bound(m_dataOffsets.begin(), m_dataOffsets.end(), end) - m_dataOffsets.begin());
+
+            if (m_DataBlocksAreSetup)
+            {
+                const std::span<const types::byte_t> range = m_data.subspan(offset, end - offset);
+                std::copy(range.begin(), range.end(), out.begin());
+                return range.size();
+            }
+
+            const std::vector<std::shared_ptr<const DataBlock>> blocks = _readDataBlocks(first, last);
+            size_t nCopied{ 0 };
+            for (size_t i = first; i < last; ++i)
+            {
+                const size_t blockStart = std::max(offset, m_dataOffsets[i]) - m_dataOffsets[i];
+                const size_t blockEnd = std::min(end, m_dataOffsets[i + 1]) - m_dataOffsets[i];
+                const std::span<const types::byte_t> data = blocks[i - first]->data().subspan(blockStart, blockEnd - blockStart);
+                std::copy(data.begin(), data.end(), out.begin() + static_cast<std::ptrdiff_t>(nCopied));
+                nCopied += data.size();
+            }
+            return nCopied;
+        }
+
         /**
         * @return pair<totalAlignedBlockSize, offset or padding>
         */
@@ -787,12 +1343,121 @@ namespace storyt::ndb {
             return { blockSize, offset };
         }
 
-    private:
+    private:
+
+        io::Bytes _readBlockBytes(uint64_t position, uint64_t blockTotalSize)
+        {
+            return m_source->read(position, blockTotalSize);
+        }
+
+        [[nodiscard]] bool _validate(core::BREF bref) const
+        {
+            return m_options.shouldValidate(m_options.ndb, bref.bid.getBidRaw());
+        }
+
+        io::Bytes _readFirstBlockBytes()
+        {
+            const auto [blockSize, offset] = calcBlockAlignedSize(m_sizeofFirstBlockData);
+            const size_t blockTrailerSize = 16U;
+
+            io::Bytes blockBytes = _readBlockBytes(m_firstBlockBREF.ib, blockSize);
+            utils::ByteView view(blockBytes.view());
+            BlockTrailer trailer = BlockTrailer::Init(view.takeLast(blockTrailerSize), m_firstBlockBREF, _validate(m_firstBlockBREF));
+
+            STORYT_ASSERT((trailer.bid == m_firstBlockBREF.bid), 
+                "Bids should match");
+            STORYT_ASSERT((blockSize - (blockTrailerSize + offset) == trailer.cb),
+                "Given BlockSize [{}] != Trailer BlockSize [{}]", blockSize, trailer.cb);
+            STORYT_ASSERT((m_sizeofFirstBlockData == trailer.cb),
+                "Given sizeofBlockData [{}] != Trailer BlockSize [{}]", m_sizeofFirstBlockData, trailer.cb);
+            return blockBytes;
+        }
+
+        /**
+         * @brief Finds the BBTEntry of every data block and where each block's data starts without reading any data block.
+        */
+        void _loadLayout()
+        {
+            if (m_layoutIsSetup)
+            {
+                return;
+            }
+            if (!m_firstBlockBREF.bid.isInternal())
+            {
+                m_dataBlockBBTs.push_back(BBTEntry{ m_firstBlockBREF, static_cast<uint16_t>(m_sizeofFirstBlockData) });
+            }
+            else
+            {
+                const io::Bytes blockBytes = _readFirstBlockBytes();
+                // XBlocks and XXBlocks share the same btype so cLevel is what tells them apart.
+                const uint32_t cLevel = blockBytes.view()[1];
+                if (cLevel == 0x01U) // XBlock
+                {
+                    _xBlocktoDataBlocks(XBlock::Init(blockBytes.view(), m_firstBlockBREF, _validate(m_firstBlockBREF)));
+                }
+                else if (cLevel == 0x02U) // XXBlock
+                {
+                    _xxBlocktoDataBlocks(XXBlock::Init(blockBytes.view(), m_firstBlockBREF, _validate(m_firstBlockBREF)));
+                }
+                else
+                {
+                    STORYT_ASSERT(false, "Invalid cLevel must 0x01 or 0x02 not [{}]", cLevel);
+                }
+            }
+            m_dataOffsets.reserve(m_dataBlockBBTs.size() + 1);
+            m_dataOffsets.push_back(0);
+            for (const BBTEntry& entry : m_dataBlockBBTs)
+            {
+                m_dataOffsets.push_back(m_dataOffsets.back() + entry.cb);
+            }
+            m_layoutIsSetup = true;
+        }
+
+        /**
+         * @brief Decodes data blocks [first, last) without keeping them in the DataTree.
+        */
+        [[nodiscard]] std::vector<std::shared_ptr<const DataBlock>> _readDataBlocks(size_t first, size_t last)
+        {
+            std::vector<std::shared_ptr<const DataBlock>> cached{};
+            std::vector<io::ReadRequest> requests{};
+            for (size_t i = first; i < last; ++i)
+            {
+                cached.push_back(_findCached(m_dataBlockBBTs[i].bref.bid));
+                if (cached.back() == nullptr)
+                {
+                    auto [totalSize, offset] = calcBlockAlignedSize(m_dataBlockBBTs[i].cb);
+                    requests.push_back({ m_dataBlockBBTs[i].bref.ib, totalSize });
+                }
+            }
+            std::vector<io::Bytes> bytes = io::ReadScheduler().read(m_source.get(), requests);
+            size_t nextMiss{ 0 };
+            for (size_t i = first; i < last; ++i)
+            {
+                std::shared_ptr<const DataBlock>& block = cached[i - first];
+                if (block == nullptr)
+                {
+                    block = _decode(std::move(bytes[nextMiss++]), m_dataBlockBBTs[i].bref);
+                }
+            }
+            return cached;
+        }
+
+        [[nodiscard]] std::shared_ptr<const DataBlock> _findCached(core::BID bid) const
+        {
+            return m_blockCache != nullptr ? m_blockCache->find(bid) : nullptr;
+        }
 
-        std::vector<types::byte_t> _readBlockBytes(uint64_t position, uint64_t blockTotalSize)
+        /**
+         * @brief Decodes a block and shares it through the block cache when there is one.
+        */
+        [[nodiscard]] std::shared_ptr<const DataBlock> _decode(io::Bytes&& bytes, core::BREF bref)
         {
-            m_file->seekg(position, std::ios::beg);
-            return utils::readBytes(m_file.get(), blockTotalSize);
+            std::shared_ptr<const DataBlock> block = std::make_shared<const DataBlock>(DataBlock::Init(std::move(bytes), bref, m_cryptMethod, _validate(bref)));
+            if (m_blockCache == nullptr)
+            {
+                return block;
+            }
+            return m_blockCache->insert(bref.bid, std::move(block));
         }
 
         void _xBlocktoDataBlocks(const XBlock& xblock)
@@ -807,42 +1472,31 @@ namespace storyt::ndb {
 
         void _xxBlocktoDataBlocks(const XXBlock& xxblock)
         {
+            // Every child XBlock is read in one batch.
+            std::vector<BBTEntry> bbts{};
+            std::vector<io::ReadRequest> requests{};
+            bbts.reserve(xxblock.nBids);
+            requests.reserve(xxblock.nBids);
             for (const core::BID& bid : xxblock.rgbid)
             {
                 const std::optional<BBTEntry> bbt = m_getBBT(bid);
                 const auto [blockSize, offset] = calcBlockAlignedSize(bbt.value().cb);
-                const std::vector <types::byte_t> bytes = _readBlockBytes(bbt.value().bref.ib, blockSize);
-                _xBlocktoDataBlocks(XBlock::Init(bytes, bbt.value().bref));
-            }
-        }
-
-        bool DataBlocksAreStoredContiguously_()
-        {
-            for (size_t i = 1; i < m_dataBlockBBTs.size(); ++i)
-            {
-                const uint64_t start = m_dataBlockBBTs.at(i - 1).bref.ib;
-                const uint64_t end = m_dataBlockBBTs.at(i).bref.ib;
-                auto [expectedSize, offset] = calcBlockAlignedSize(m_dataBlockBBTs.at(i - 1).cb);
-                if (start > end || end - start != expectedSize)
-                {
-                    return false;
-                }
+                bbts.push_back(bbt.value());
+                requests.push_back({ bbt.value().bref.ib, blockSize });
             }
-            return true;
-        }
-
-        size_t TotalDataBlockFileBytes_()
-        {
-            STORYT_ASSERT(DataBlocksAreStoredContiguously_(), "Data Blocks Are NOT Stored Contiguously");
-            size_t nBytes{ 0 };
-            for (const auto& entry : m_dataBlockBBTs)
+            const std::vector<io::Bytes> blocks = io::ReadScheduler().read(m_source.get(), requests);
+            for (size_t i = 0; i < bbts.size(); ++i)
             {
-                auto [totalSize, offset] = calcBlockAlignedSize(entry.cb);
-                nBytes += totalSize;
+                _xBlocktoDataBlocks(XBlock::Init(blocks[i].view(), bbts[i].bref, _validate(bbts[i].bref)));
             }
-            return nBytes;
         }
 
+        /**
+         * @brief Copies every data block into one allocation laid out by m_dataOffsets. Blocks already in the
+         *  block cache are copied out of it and only the rest are read and decoded straight into place.
+         *  The cache is then given blocks that view their slice of the allocation, so reopening the DataTree
+         *  does not read them again and nothing is decoded or held twice.
+        */
         void _flush()
         {
             if (m_dataBlockBBTs.empty())
@@ -850,37 +1504,236 @@ namespace storyt::ndb {
                 STORYT_ERROR("[WARN] Flush was called with 0 data block BBTs");
                 return;
             }
-            m_dataBlocks.reserve(m_dataBlockBBTs.size());
-            if (DataBlocksAreStoredContiguously_())
+            auto data = std::make_shared<TreeData>();
+            data->bytes.resize(m_dataOffsets.back());
+            const std::span<types::byte_t> out(data->bytes);
+            auto blockOut = [this, out](size_t i) {
+                return out.subspan(m_dataOffsets[i], m_dataOffsets[i + 1] - m_dataOffsets[i]);
+            };
+            auto place = [&blockOut](const DataBlock& block, size_t i) {
+                const std::span<types::byte_t> dest = blockOut(i);
+                STORYT_ASSERT((block.data().size() == dest.size()), 
+                    "DataBlock size [{}] != BBTEntry cb [{}]", block.data().size(), dest.size());
+                const std::span<const types::byte_t> src = block.data().first(std::min(block.data().size(), dest.size()));
+                std::copy(src.begin(), src.end(), dest.begin());
+            };
+
+            std::vector<size_t> misses{};
+            std::vector<io::ReadRequest> requests{};
+            for (size_t i = 0; i < m_dataBlockBBTs.size(); ++i)
             {
-                const size_t nBytes = TotalDataBlockFileBytes_();
-                std::vector<types::byte_t> allBlocksBytes = _readBlockBytes(m_dataBlockBBTs.at(0).bref.ib, nBytes);
-                utils::ByteView view(allBlocksBytes);
-                for (const auto& entry : m_dataBlockBBTs)
+                const BBTEntry& entry = m_dataBlockBBTs[i];
+                if (const std::shared_ptr<const DataBlock> cached = _findCached(entry.bref.bid))
                 {
-                    auto [totalSize, offset] = calcBlockAlignedSize(entry.cb);
-                    m_dataBlocks.push_back(DataBlock::Init(view.read(totalSize), entry.bref));
+                    place(*cached, i);
+                    continue;
                 }
+                auto [totalSize, offset] = calcBlockAlignedSize(entry.cb);
+                misses.push_back(i);
+                requests.push_back({ entry.bref.ib, totalSize });
             }
-            else
+            // Every miss is read in one batch with neighbouring blocks merged into single reads.
+            std::vector<io::Bytes> blocks = io::ReadScheduler().read(m_source.get(), requests);
+            for (size_t m = 0; m < misses.size(); ++m)
             {
-                for (const auto& entry : m_dataBlockBBTs)
+                const size_t i = misses[m];
+                const core::BREF bref = m_dataBlockBBTs[i].bref;
+                const BlockTrailer trailer = DataBlock::DecodeInto(blocks[m].view(), bref, m_cryptMethod, _validate(bref), blockOut(i));
+                if (m_blockCache != nullptr)
                 {
-                    auto [totalSize, offset] = calcBlockAlignedSize(entry.cb);
-                    m_dataBlocks.push_back(DataBlock::Init(_readBlockBytes(entry.bref.ib, totalSize), entry.bref));
+                    // The aliasing shared_ptr keeps the whole allocation alive for as long as the cache holds the block.
+                    const DataBlock& block = data->blocks.emplace_back(DataBlock::View(blockOut(i), trailer));
+                    static_cast<void>(m_blockCache->insert(bref.bid, std::shared_ptr<const DataBlock>(data, &block)));
                 }
             }
+            m_data = out;
+            m_dataOwner = std::move(data);
         }
 
     private:
-        core::Ref<std::ifstream> m_file;
+        /// The data of a multi block DataTree and the DataBlocks that view it which were handed to the block cache.
+        struct TreeData
+        {
+            std::vector<types::byte_t> bytes{};
+            std::deque<DataBlock> blocks{};
+        };
+
+    private:
+        core::Ref<const io::BlockSource> m_source;
         core::BREF m_firstBlockBREF;
         GetBBT_t m_getBBT;
         size_t m_sizeofFirstBlockData{ 0 };
         std::vector<BBTEntry> m_dataBlockBBTs{};
-        std::vector<DataBlock> m_dataBlocks{};
+        /// Keeps m_data alive. Either the one DataBlock of a single block DataTree or a buffer holding every block.
+        /// Copies of a DataTree share it since the data is never written after it is decoded.
+        std::shared_ptr<const void> m_dataOwner{};
+        std::span<const types::byte_t> m_data{};
         bool m_DataBlocksAreSetup{ false };
+        /// m_dataOffsets[i] is the offset of data block i's data within the DataTree's data. The last entry is the total size.
+        std::vector<size_t> m_dataOffsets{};
+        bool m_layoutIsSetup{ false };
+        types::CryptMethod m_cryptMethod{ types::CryptMethod::PERMUTE };
+        core::ReadOptions m_options{};
+        /// Owned by the NDB. nullptr when the DataTree is not backed by a cache.
+        BlockCache* m_blockCache{ nullptr };
+
+        friend class DataTreeReader;
+    };
+
+    /**
+    * @brief Reads the data of a DataTree front to back one block at a time into a buffer the caller owns. 
+    *  Only the BIDs of the current XBlock, and a block that is split across reads, are held so memory use stays
+    *  the same no matter how big the data is. Blocks are read, checked and decoded as they are reached and skip
+    *  the block cache so streaming a large attachment does not flush it.
+    */
+    class DataTreeReader
+    {
+    public:
+        explicit DataTreeReader(const DataTree& tree)
+            : 
+            m_source(tree.m_source), 
+            m_getBBT(tree.m_getBBT), 
+            m_cryptMethod(tree.m_cryptMethod), 
+            m_options(tree.m_options)
+        {
+            const core::BREF bref = tree.m_firstBlockBREF;
+            if (!bref.bid.isInternal())
+            {
+                // A single data block is not read until the first call to read so it can go straight into the buffer.
+                m_firstBlock = BBTEntry{ bref, static_cast<uint16_t>(tree.m_sizeofFirstBlockData) };
+                m_size = tree.m_sizeofFirstBlockData;
+                return;
+            }
+            const io::Bytes bytes = _readBlockBytes(bref, tree.m_sizeofFirstBlockData);
+            // XBlocks and XXBlocks share the same btype so cLevel is what tells them apart.
+            const uint32_t cLevel = bytes.view()[1];
+            if (cLevel == 0x01U) 
+            {
+                const XBlock xblock = XBlock::Init(bytes.view(), bref, _validate(bref));
+                m_size = xblock.lcbTotal;
+                m_xBids = xblock.rgbid;
+            }
+            else if (cLevel == 0x02U)
+            {
+                const XXBlock xxblock = XXBlock::Init(bytes.view(), bref, _validate(bref));
+                m_size = xxblock.lcbTotal;
+                m_xxBids = xxblock.rgbid;
+            }
+            else
+            {
+                STORYT_ASSERT(false, "Invalid cLevel must 0x01 or 0x02 not [{}]", cLevel);
+            }
+        }
+
+        /**
+         * @brief The total number of bytes of data in the DataTree.
+        */
+        [[nodiscard]] size_t size() const { return m_size; }
+        [[nodiscard]] size_t nBytesRead() const { return m_nBytesRead; }
+        [[nodiscard]] bool done() const { return m_nBytesRead >= m_size; }
+
+        /**
+         * @brief Copies the next bytes of data into buffer. A block that fits in the rest of buffer is decoded
+         *  straight into it, only a block that is split across calls is decoded into a block of its own first.
+         * @return the number of bytes copied. This is only less than buffer.size() at the end of the data.
+        */
+        size_t read(std::span<types::byte_t> buffer)
+        {
+            size_t nCopied{ 0 };
+            while (nCopied < buffer.size())
+            {
+                if (m_block.has_value() && m_blockOffset < m_block->data().size())
+                {
+                    const std::span<const types::byte_t> data = m_block->data().subspan(m_blockOffset);
+                    const size_t n = std::min(data.size(), buffer.size() - nCopied);
+                    std::copy_n(data.begin(), n, buffer.begin() + static_cast<std::ptrdiff_t>(nCopied));
+                    nCopied += n;
+                    m_blockOffset += n;
+                    continue;
+                }
+                m_block.reset();
+                const std::optional<BBTEntry> bbt = _nextBBT();
+                if (!bbt.has_value())
+                {
+                    break;
+                }
+                io::Bytes bytes = _readBlockBytes(bbt->bref, bbt->cb);
+                if (bbt->cb <= buffer.size() - nCopied)
+                {
+                    DataBlock::DecodeInto(bytes.view(), bbt->bref, m_cryptMethod, _validate(bbt->bref), buffer.subspan(nCopied, bbt->cb));
+                    nCopied += bbt->cb;
+                }
+                else
+                {
+                    m_block.emplace(DataBlock::Init(std::move(bytes), bbt->bref, m_cryptMethod, _validate(bbt->bref)));
+                    m_blockOffset = 0;
+                }
+            }
+            m_nBytesRead += nCopied;
+            return nCopied;
+        }
+
+    private:
+        /**
+         * @brief The BBTEntry of the next data block or std::nullopt when every block has been read.
+        */
+        std::optional<BBTEntry> _nextBBT()
+        {
+            if (m_firstBlock.has_value())
+            {
+                return std::exchange(m_firstBlock, std::nullopt);
+            }
+            // The data block BIDs come from the current XBlock and the XBlocks come from the XXBlock.
+            while (m_nextX == m_xBids.size())
+            {
+                if (m_nextXX == m_xxBids.size())
+                {
+                    return std::nullopt;
+                }
+                const BBTEntry xbbt = _getBBT(m_xxBids[m_nextXX++]);
+                const io::Bytes bytes = _readBlockBytes(xbbt.bref, xbbt.cb);
+                m_xBids = XBlock::Init(bytes.view(), xbbt.bref, _validate(xbbt.bref)).rgbid;
+                m_nextX = 0;
+            }
+            return _getBBT(m_xBids[m_nextX++]);
+        }
+
+        [[nodiscard]] BBTEntry _getBBT(core::BID bid) const
+        {
+            const std::optional<BBTEntry> bbt = m_getBBT(bid);
+            STORYT_ASSERT(bbt.has_value(), "Failed to find BBTEntry with BID [{}]", bid.getBidRaw());
+            return bbt.value();
+        }
+
+        [[nodiscard]] io::Bytes _readBlockBytes(core::BREF bref, size_t sizeofBlockData) const
+        {
+            const auto [blockSize, offset] = DataTree::calcBlockAlignedSize(sizeofBlockData);
+            return m_source->read(bref.ib, blockSize);
+        }
+
+        [[nodiscard]] bool _validate(core::BREF bref) const
+        {
+            return m_options.shouldValidate(m_options.ndb, bref.bid.getBidRaw());
+        }
+
+    private:
+        core::Ref<const io::BlockSource> m_source;
+        DataTree::GetBBT_t m_getBBT;
+        types::CryptMethod m_cryptMethod{ types::CryptMethod::PERMUTE };
+        core::ReadOptions m_options{};
+        size_t m_size{ 0 };
+        size_t m_nBytesRead{ 0 };
+        std::vector<core::BID> m_xxBids{};
+        size_t m_nextXX{ 0 };
+        std::vector<core::BID> m_xBids{};
+        size_t m_nextX{ 0 };
+        /// Set until a DataTree made of a single data block has been read
+        std::optional<BBTEntry> m_firstBlock{};
+        /// Only holds a block that did not fit in the rest of the buffer passed to read
+        std::optional<DataBlock> m_block{};
+        size_t m_blockOffset{ 0 };
     };
+
     /**
         * @brief SLENTRY are records that refer to internal subnodes of a node.
     */
@@ -894,7 +1747,7 @@ namespace storyt::ndb {
         /// (8 bytes; ANSI: 4 bytes): If nonzero, the BID of the subnode of this subnode.
         core::BID bidSub;
 
-        explicit SLEntry(const std::vector<types::byte_t>& bytes)
+        explicit SLEntry(std::span<const types::byte_t> bytes)
         {
             STORYT_ASSERT((bytes.size() == 24), "bytes.size() [{}] != SLEntry::size [24]", bytes.size());
             utils::ByteView view(bytes);
@@ -916,7 +1769,7 @@ namespace storyt::ndb {
         /// (Unicode: 8 bytes; ANSI: 4 bytes): The BID of the SLBLOCK
         core::BID bid;
 
-        explicit SIEntry(const std::vector<types::byte_t>& bytes)
+        explicit SIEntry(std::span<const types::byte_t> bytes)
         {
             STORYT_ASSERT((bytes.size() == 16), "bytes.size() [{}] != SIEntry size [16]", bytes.size());
             utils::ByteView view(bytes);
@@ -943,14 +1796,14 @@ namespace storyt::ndb {
         /// (Unicode: 16 bytes): A BLOCKTRAILER structure
         const BlockTrailer trailer;
 
-        static SLBlock Init(const std::vector<types::byte_t>& bytes, core::BREF bref)
+        static SLBlock Init(std::span<const types::byte_t> bytes, core::BREF bref, bool validate = true)
         {
             STORYT_ASSERT(bref.bid.isInternal(), "SLBlock should be marked as an Internal Block");
             utils::ByteView view(bytes);
-            return SLBlock(bytes, BlockTrailer(view.takeLast(16), bref));
+            return SLBlock(bytes, BlockTrailer::Init(view.takeLast(16), bref, validate));
         }
 
-        explicit SLBlock(const std::vector<types::byte_t>& bytes, BlockTrailer&& trailer_)
+        explicit SLBlock(std::span<const types::byte_t> bytes, BlockTrailer&& trailer_)
             : trailer(trailer_)
         {  
             utils::ByteView view(bytes);
@@ -982,232 +1835,775 @@ namespace storyt::ndb {
         /// (16 bytes)
         const BlockTrailer trailer;
 
-        static SIBlock Init(const std::vector<types::byte_t>& bytes, core::BREF bref)
+        static SIBlock Init(std::span<const types::byte_t> bytes, core::BREF bref, bool validate = true)
+        {
+            STORYT_ASSERT(bref.bid.isInternal(), "SIBlock should be marked as an Internal Block");
+            utils::ByteView view(bytes);
+            return SIBlock(bytes, BlockTrailer::Init(view.takeLast(16), bref, validate));
+        }
+
+        explicit SIBlock(std::span<const types::byte_t> bytes, BlockTrailer&& trailer_)
+            : trailer(trailer_)
+        {
+            utils::ByteView view(bytes);
+            btype = view.read<uint8_t>(1);
+            cLevel = view.read<uint8_t>(1);
+            cEnt = view.read<uint16_t>(2);
+            dwPadding = view.read<uint32_t>(4);
+            entries = view.entries<SIEntry>(cEnt, 16);
+            STORYT_ASSERT((btype == 0x02), "btype != 0x02");
+            STORYT_ASSERT((cLevel == 0x01), "cLevel != 0x01");
+        }
+    };
+
+    class SubNodeBTree
+    {
+    public:
+        using GetBBT_t = std::function<std::optional<BBTEntry>(const core::BID& bid)>;
+            
+    public:
+        SubNodeBTree(
+            core::BID bid, 
+            core::Ref<const io::BlockSource> source, 
+            const GetBBT_t& getBBT, 
+            types::CryptMethod cryptMethod = types::CryptMethod::PERMUTE,
+            core::ReadOptions options = {},
+            BlockCache* blockCache = nullptr
+        )
+            : m_bid(bid), m_source(source), m_getBBT(getBBT), m_cryptMethod(cryptMethod), m_options(options), m_blockCache(blockCache)
+        {
+            if (m_bid.getBidRaw() != 0) //&& m_bid.getBidRaw() != 1978398) // When BID == 0 there is no subnode tree
+            {
+                const auto [bytes, bbt] = _readBlockBytes(m_bid);
+                const uint8_t clevel = bytes.view()[1];
+                if (clevel == 0x00) // SL Block
+                {
+                    _slBlockToSLEntries(SLBlock::Init(bytes.view(), bbt.bref, _validate(bbt.bref)));
+                }
+                else if (clevel == 0x01) // SI Block
+                {
+                    _siBlockToSLEntries(SIBlock::Init(bytes.view(), bbt.bref, _validate(bbt.bref)));
+                }
+                else // Encountered Invalid Block Type
+                {
+                    STORYT_ASSERT(false, "Invalid Block Type [{}]", clevel);
+                }
+
+                // Nested SubNodeBTrees and DataTrees are only created when they are first asked for so
+                // opening a node reads nothing but its SL/SI blocks.
+                std::sort(m_slentries.begin(), m_slentries.end(), [](const SLEntry& lhs, const SLEntry& rhs) {
+                    return lhs.nid.getNIDRaw() < rhs.nid.getNIDRaw();
+                });
+                for (size_t i = 1; i < m_slentries.size(); ++i)
+                {
+                    STORYT_ASSERT((m_slentries[i - 1].nid.getNIDRaw() != m_slentries[i].nid.getNIDRaw()),
+                        "Duplicate NID [{}] in SubNodeBTree", m_slentries[i].nid.getNIDRaw());
+                }
+            }
+        }
+
+        /**
+         * @brief The loaded DataTree with nid from this SubNodeBTree or any SubNodeBTree nested in it.
+         *  Nested levels are only read until nid is found. _findAnyEntry documents which entry wins when nid is repeated.
+        */
+        [[nodiscard]] DataTree* getDataTree(core::NID nid)
+        {
+            std::lock_guard<std::mutex> lock(m_resolved.mutex);
+            const SLEntry* slentry = _findAnyEntry(nid);
+            DataTree* data = slentry != nullptr ? _getDataTree(*slentry) : nullptr;
+            return data != nullptr ? &data->load() : nullptr; // Make sure Data Tree is loaded
+        }
+
+        /**
+         * @brief A streaming reader over the DataTree with nid. Unlike getDataTree the DataTree is not loaded.
+        */
+        [[nodiscard]] std::optional<DataTreeReader> getDataTreeReader(core::NID nid) const
+        {
+            std::lock_guard<std::mutex> lock(m_resolved.mutex);
+            const SLEntry* slentry = _findAnyEntry(nid);
+            const DataTree* data = slentry != nullptr ? _getDataTree(*slentry) : nullptr;
+            return data != nullptr ? std::optional<DataTreeReader>(DataTreeReader(*data)) : std::nullopt;
+        }
+
+        [[nodiscard]] SubNodeBTree* getNestedSubNodeTree(core::NID nid)
+        {
+            std::lock_guard<std::mutex> lock(m_resolved.mutex);
+            const SLEntry* slentry = _findEntry(nid);
+            return slentry != nullptr ? _getSubtree(*slentry) : nullptr;
+        }
+
+        [[nodiscard]] const SubNodeBTree* const getNestedSubNodeTree(core::NID nid) const
+        {
+            std::lock_guard<std::mutex> lock(m_resolved.mutex);
+            const SLEntry* slentry = _findEntry(nid);
+            return slentry != nullptr ? _getSubtree(*slentry) : nullptr;
+        }
+
+        /**
+         * @brief 
+         * @param dataSize is the size of btype + clevel + cEnt + dwpadding + plus cEnt * Entry Size  
+        */
+        static size_t calcBlockAlignedSize(size_t dataSize)
+        {
+            const size_t blockTrailerSize = 16;
+            const size_t totalBlockSizeWithoutPadding = dataSize + blockTrailerSize; // +sBType + sCLevel + sCEnt + sDwPadding;
+
+            const size_t multiple = 64;
+            const size_t remainder = totalBlockSizeWithoutPadding % multiple;
+            const size_t offset = (multiple * (remainder != 0)) - remainder;
+            // The block size is the smallest multiple of 64 that can hold both the data and the block trailer.
+            return totalBlockSizeWithoutPadding + offset;
+        }
+
+    private:
+        [[nodiscard]] const SLEntry* _findEntry(core::NID nid) const
+        {
+            const auto it = std::lower_bound(m_slentries.begin(), m_slentries.end(), nid.getNIDRaw(), [](const SLEntry& entry, uint32_t id) {
+                return entry.nid.getNIDRaw() < id;
+            });
+            return (it != m_slentries.end() && it->nid.getNIDRaw() == nid.getNIDRaw()) ? &(*it) : nullptr;
+        }
+
+        /**
+         * @brief Finds nid in this SubNodeBTree first and then one nesting level at a time. A level is only read
+         *  when nid is in none of the levels above it so a hit never reads the SL/SI blocks below it, but a miss
+         *  still reads every nested level.
+         *  NIDs are only unique within their parent so the shallowest entry wins. Within a level the entry that
+         *  wins is the one whose parents come first in NID order, e.g. under 0x1 rather than 0x2.
+        */
+        [[nodiscard]] const SLEntry* _findAnyEntry(core::NID nid) const
+        {
+            if (const SLEntry* slentry = _findEntry(nid))
+            {
+                return slentry;
+            }
+            for (size_t depth = 0; depth < m_resolved.nestedLevels.size() || _indexNextLevel(); ++depth)
+            {
+                const std::vector<SLEntry>& entries = m_resolved.nestedLevels[depth].entries;
+                const auto it = std::lower_bound(entries.begin(), entries.end(), nid.getNIDRaw(), [](const SLEntry& entry, uint32_t id) {
+                    return entry.nid.getNIDRaw() < id;
+                });
+                if (it != entries.end() && it->nid.getNIDRaw() == nid.getNIDRaw())
+                {
+                    return &(*it);
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief Reads the SubNodeBTrees nested in the deepest indexed level, or in this one, and indexes their SLEntries.
+         * @return false when there is no deeper level
+        */
+        bool _indexNextLevel() const
+        {
+            if (m_resolved.nestedIsComplete)
+            {
+                return false;
+            }
+            std::vector<const SubNodeBTree*> parents{ this };
+            if (!m_resolved.nestedLevels.empty())
+            {
+                parents = m_resolved.nestedLevels.back().trees;
+            }
+            NestedLevel level{};
+            for (const SubNodeBTree* parent : parents)
+            {
+                // Locks are only taken from a tree down to the trees nested in it so two can never wait on each other.
+                std::unique_lock<std::mutex> lock(parent->m_resolved.mutex, std::defer_lock);
+                if (parent != this)
+                {
+                    lock.lock();
+                }
+                for (const SLEntry& slentry : parent->m_slentries)
+                {
+                    if (const SubNodeBTree* subtree = parent->_getSubtree(slentry))
+                    {
+                        level.trees.push_back(subtree);
+                        level.entries.insert(level.entries.end(), subtree->m_slentries.begin(), subtree->m_slentries.end());
+                    }
+                }
+            }
+            if (level.trees.empty())
+            {
+                m_resolved.nestedIsComplete = true;
+                return false;
+            }
+            // The parents and their entries are already in NID order so a stable sort keeps the first owner first.
+            std::stable_sort(level.entries.begin(), level.entries.end(), [](const SLEntry& lhs, const SLEntry& rhs) {
+                return lhs.nid.getNIDRaw() < rhs.nid.getNIDRaw();
+            });
+            level.entries.erase(std::unique(level.entries.begin(), level.entries.end(), [](const SLEntry& lhs, const SLEntry& rhs) {
+                return lhs.nid.getNIDRaw() == rhs.nid.getNIDRaw();
+            }), level.entries.end());
+            m_resolved.nestedLevels.push_back(std::move(level));
+            return true;
+        }
+
+        /**
+         * @brief The DataTree of slentry, created with a BBT lookup the first time it is asked for. The DataTree is not loaded.
+         *  Like every helper that touches m_resolved, the caller holds m_resolved.mutex.
+        */
+        [[nodiscard]] DataTree* _getDataTree(const SLEntry& slentry) const
+        {
+            const uint32_t nidID = slentry.nid.getNIDRaw();
+            if (const auto it = m_resolved.datatrees.find(nidID); it != m_resolved.datatrees.end())
+            {
+                return &it->second;
+            }
+            const std::optional<BBTEntry> dataTreeBBT = m_getBBT(slentry.bidData);
+            if (!dataTreeBBT.has_value())
+            {
+                STORYT_ERROR("Failed to find BBTEntry with BID [{}]", slentry.bidData.getBidRaw());
+                return nullptr;
+            }
+            const auto [it, inserted] = m_resolved.datatrees.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(nidID),
+                std::forward_as_tuple(m_source, m_getBBT, dataTreeBBT.value().bref, dataTreeBBT.value().cb, m_cryptMethod, m_options, m_blockCache)
+            );
+            return &it->second;
+        }
+
+        /**
+         * @brief The nested SubNodeBTree of slentry, read the first time it is asked for. nullptr when slentry has none.
+        */
+        [[nodiscard]] SubNodeBTree* _getSubtree(const SLEntry& slentry) const
+        {
+            if (slentry.bidSub.getBidRaw() == 0) // there is no nested subnode btree
+            {
+                return nullptr;
+            }
+            const uint32_t nidID = slentry.nid.getNIDRaw();
+            if (const auto it = m_resolved.subtrees.find(nidID); it != m_resolved.subtrees.end())
+            {
+                return &it->second;
+            }
+            const auto [it, inserted] = m_resolved.subtrees.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(nidID),
+                std::forward_as_tuple(slentry.bidSub, m_source, m_getBBT, m_cryptMethod, m_options, m_blockCache)
+            );
+            return &it->second;
+        }
+
+        void _slBlockToSLEntries(const SLBlock& block) // SL Block to SL Entries
+        {
+            for (const SLEntry& slentry : block.entries)
+            {
+                m_slentries.push_back(slentry);
+            }
+        }
+
+        void _siBlockToSLEntries(const SIBlock& block) // SI Block to SL Entries
+        {
+            std::vector<BBTEntry> entries;
+            entries.reserve(block.entries.size());
+            for (const SIEntry& sientry : block.entries)
+            {
+                const std::optional<BBTEntry> bbt = m_getBBT(sientry.bid);
+                entries.push_back(bbt.value());
+            }
+            // The SLBlocks are not guaranteed to be stored next to each other but the ones that are get merged into one read.
+            std::vector<io::ReadRequest> requests{};
+            requests.reserve(entries.size());
+            for (const BBTEntry& bbt : entries)
+            {
+                requests.push_back({ bbt.bref.ib, calcBlockAlignedSize(bbt.cb) });
+            }
+            const std::vector<io::Bytes> blocks = io::ReadScheduler().read(m_source.get(), requests);
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                _slBlockToSLEntries(SLBlock::Init(blocks[i].view(), entries[i].bref, _validate(entries[i].bref)));
+            }
+        }
+
+        io::Bytes _readBlockBytes(uint64_t position, uint64_t totalSize)
+        {
+            return m_source->read(position, totalSize);
+        }
+
+        [[nodiscard]] bool _validate(core::BREF bref) const
         {
-            STORYT_ASSERT(bref.bid.isInternal(), "SIBlock should be marked as an Internal Block");
-            utils::ByteView view(bytes);
-            return SIBlock(bytes, BlockTrailer(view.takeLast(16), bref));
+            return m_options.shouldValidate(m_options.ndb, bref.bid.getBidRaw());
         }
 
-        explicit SIBlock(const std::vector<types::byte_t>& bytes, BlockTrailer&& trailer_)
-            : trailer(trailer_)
+        std::pair<io::Bytes, BBTEntry> _readBlockBytes(core::BID bid)
         {
-            utils::ByteView view(bytes);
-            btype = view.read<uint8_t>(1);
-            cLevel = view.read<uint8_t>(1);
-            cEnt = view.read<uint16_t>(2);
-            dwPadding = view.read<uint32_t>(4);
-            entries = view.entries<SIEntry>(cEnt, 16);
-            STORYT_ASSERT((btype == 0x02), "btype != 0x02");
-            STORYT_ASSERT((cLevel == 0x01), "cLevel != 0x01");
+            const std::optional<BBTEntry> bbt = m_getBBT(bid);
+            const size_t totalBlockSize = calcBlockAlignedSize(bbt.value().cb);
+            return { _readBlockBytes(bbt.value().bref.ib, totalBlockSize), bbt.value() };
         }
-    };
 
-    class SubNodeBTree
-    {
-    public:
-        using GetBBT_t = std::function<std::optional<BBTEntry>(const core::BID& bid)>;
-            
-    public:
-        SubNodeBTree(core::BID bid, core::Ref<std::ifstream> file, const GetBBT_t& getBBT)
-            : m_bid(bid), m_file(file), m_getBBT(getBBT)
+    private:
+        core::BID m_bid;
+        core::Ref<const io::BlockSource> m_source;
+        GetBBT_t m_getBBT;
+        types::CryptMethod m_cryptMethod{ types::CryptMethod::PERMUTE };
+        core::ReadOptions m_options{};
+        BlockCache* m_blockCache{ nullptr };
+        /// Sorted by NID
+        std::vector<SLEntry> m_slentries;
+
+        struct NestedLevel
         {
-            if (m_bid.getBidRaw() != 0) //&& m_bid.getBidRaw() != 1978398) // When BID == 0 there is no subnode tree
+            /// The nested SubNodeBTrees at this level, in the order their parents were walked
+            std::vector<const SubNodeBTree*> trees{};
+            /// Their SLEntries sorted by NID with only the first owner of a repeated NID kept
+            std::vector<SLEntry> entries{};
+        };
+
+        /**
+         * @brief Everything that is read the first time it is asked for. The const lookups fill it too so every
+         *  method that touches it holds mutex, which lets threads share a const SubNodeBTree. A copy holds the
+         *  other's lock while it copies and gets a mutex of its own.
+        */
+        struct Resolved
+        {
+            /// Filled as nested SubNodeBTrees are first asked for. uint32_t is a Raw NID
+            std::unordered_map<uint32_t, SubNodeBTree> subtrees{};
+            /// Filled as DataTrees are first asked for, including those of nested SubNodeBTrees. uint32_t is a Raw NID
+            std::unordered_map<uint32_t, DataTree> datatrees{};
+            /// One per nesting level below this SubNodeBTree, added by _indexNextLevel as lookups miss the levels above.
+            /// The trees are owned by the subtrees of their parents and stay put, so the pointers live as long as this does.
+            std::vector<NestedLevel> nestedLevels{};
+            bool nestedIsComplete{ false };
+            mutable std::mutex mutex{};
+
+            Resolved() = default;
+            Resolved(const Resolved& other)
+                : Resolved(other, std::lock_guard<std::mutex>(other.mutex)) {}
+            Resolved(Resolved&& other) noexcept
+                : subtrees(std::move(other.subtrees)), datatrees(std::move(other.datatrees)),
+                nestedLevels(std::move(other.nestedLevels)), nestedIsComplete(other.nestedIsComplete) {}
+            Resolved& operator=(const Resolved& other)
             {
-                const auto [bytes, bbt] = _readBlockBytes(m_bid);
-                const uint8_t clevel = bytes.at(1);
-                if (clevel == 0x00) // SL Block
-                {
-                    _slBlockToSLEntries(SLBlock::Init(bytes, bbt.bref));
-                }
-                else if (clevel == 0x01) // SI Block
+                if (this != &other)
                 {
-                    _siBlockToSLEntries(SIBlock::Init(bytes, bbt.bref));
-                }
-                else // Encountered Invalid Block Type
-                {
-                    STORYT_ASSERT(false, "Invalid Block Type [{}]", clevel);
+                    std::scoped_lock lock(mutex, other.mutex);
+                    subtrees = other.subtrees;
+                    datatrees = other.datatrees;
+                    nestedLevels.clear(); // They point at other's trees so this re-indexes its own
+                    nestedIsComplete = false;
                 }
+                return *this;
+            }
+            Resolved& operator=(Resolved&& other) noexcept
+            {
+                subtrees = std::move(other.subtrees);
+                datatrees = std::move(other.datatrees);
+                nestedLevels = std::move(other.nestedLevels);
+                nestedIsComplete = other.nestedIsComplete;
+                return *this;
+            }
 
-                m_subtrees.reserve(m_slentries.size());
-                m_datatrees.reserve(m_slentries.size());
+        private:
+            Resolved(const Resolved& other, const std::lock_guard<std::mutex>&)
+                : subtrees(other.subtrees), datatrees(other.datatrees) {} // nestedLevels point at other's trees so this re-indexes its own
+        };
+        mutable Resolved m_resolved{};
+    };
 
-                for (const SLEntry& slentry : m_slentries)
-                {
-                    const uint32_t nidID = slentry.nid.getNIDRaw();
-                    STORYT_ASSERT(!m_subtrees.contains(nidID), "Duplicate entry in Nested SubNodeBTree Map");
-                    STORYT_ASSERT(!m_datatrees.contains(nidID), "Duplicate entry In DataTree Map");
-                    if (slentry.bidSub.getBidRaw() != 0) // theres a nested subnode btree
-                    {
-                        m_subtrees.emplace(
-                            std::piecewise_construct,
-                            std::forward_as_tuple(nidID),
-                            std::forward_as_tuple(slentry.bidSub, m_file, m_getBBT)
-                        );
-                    }
-                    const std::optional<BBTEntry> dataTreeBBT = m_getBBT(slentry.bidData);
-                    if (dataTreeBBT.has_value())
-                    {
-                        m_datatrees.emplace(
-                            std::piecewise_construct,
-                            std::forward_as_tuple(nidID),
-                            std::forward_as_tuple(m_file, m_getBBT, dataTreeBBT.value().bref, dataTreeBBT.value().cb)
-                        );
-                    }
-                    else
-                    {
-                        STORYT_ERROR("Failed to find BBTEntry with BID [{}]", slentry.bidData.getBidRaw());
-                    }   
-                }
+    /**
+    * @brief Reads the blocks of the file front to back in large chunks and rebuilds the data of the nodes asked for
+    *  as their blocks go by, instead of walking folder -> message -> block and seeking for every block.
+    *  It takes two passes over the file in BREF.ib order:
+    *   1. Only the XBlocks and XXBlocks of the nodes are read to learn which data blocks make up each node and where
+    *      they go. The XXBlocks' XBlocks take a second read, and SLBlocks and SIBlocks are never read.
+    *   2. Every data block that a node needs is read, checked and decoded once, then copied into each node that
+    *      uses it. A node is handed over as soon as its last block arrives so only unfinished nodes stay in memory.
+    */
+    class SequentialScan
+    {
+    public:
+        static constexpr size_t DefaultChunkBytes = 8ULL * 1024ULL * 1024ULL;
+        /// Gaps between blocks this small are read through instead of starting a new read.
+        static constexpr size_t MaxGapBytes = 64ULL * 1024ULL;
+        /// Called with the key given to addNode and the node's data, the same bytes DataTree::combineDataBlocks returns.
+        using OnNode_t = std::function<void(uint64_t key, std::vector<types::byte_t>&& data)>;
+
+    public:
+        /**
+         * @param blocks = every BBTEntry of the file, in any order.
+         * @param chunkBytes = the most bytes of blocks read and held at once.
+        */
+        SequentialScan(
+            const io::BlockSource& source,
+            std::vector<BBTEntry> blocks,
+            types::CryptMethod cryptMethod = types::CryptMethod::PERMUTE,
+            core::ReadOptions options = {},
+            size_t chunkBytes = DefaultChunkBytes
+        )
+            : 
+            m_source(source), 
+            m_blocks(std::move(blocks)), 
+            m_cryptMethod(cryptMethod), 
+            m_options(options), 
+            m_chunkBytes(chunkBytes)
+        {
+            std::sort(m_blocks.begin(), m_blocks.end(), [](const BBTEntry& lhs, const BBTEntry& rhs) { return lhs.bref.ib < rhs.bref.ib; });
+            m_blockIdx.reserve(m_blocks.size());
+            for (size_t i = 0; i < m_blocks.size(); ++i)
+            {
+                m_blockIdx.emplace(m_blocks[i].bref.bid.getBidRaw(), i);
             }
         }
 
-        [[nodiscard]] DataTree* getDataTree(core::NID nid)
+        /**
+         * @param key = handed back with the node's data.
+         * @param bidData = the BID of the first block of the node's DataTree. Nodes can share blocks.
+        */
+        void addNode(uint64_t key, core::BID bidData)
+        {
+            m_nodes.push_back({ key, bidData });
+        }
+
+        /**
+         * @brief Hands every node that could be rebuilt to onNode.
+         * @return the keys of the nodes that could not be rebuilt because a block of their DataTree is missing
+         *  from the BBT or is not an XBlock or XXBlock where one was expected. onNode is never called for them.
+        */
+        std::vector<uint64_t> run(const OnNode_t& onNode)
         {
-            if (m_datatrees.contains(nid.getNIDRaw()))
+            // Pass 1: the XBlocks and XXBlocks the nodes start at, then the XBlocks of those XXBlocks.
+            std::unordered_set<uint64_t> internalBids{};
+            for (const Node& node : m_nodes)
             {
-                return &m_datatrees.at(nid.getNIDRaw()).load();
+                if (node.bidData.isInternal())
+                {
+                    internalBids.insert(node.bidData.getBidRaw());
+                }
+            }
+            while (!internalBids.empty())
+            {
+                std::unordered_set<uint64_t> childBids{};
+                _forEachBlock(
+                    [&internalBids](const BBTEntry& bbt) { return internalBids.contains(bbt.bref.bid.getBidRaw()); },
+                    [this, &childBids](const BBTEntry& bbt, io::Bytes&& bytes) { _addInternalBlock(bbt, bytes.view(), childBids); }
+                );
+                internalBids = std::move(childBids);
             }
-            for (auto& [_, subtree] : m_subtrees)
+            _resolveNodes();
+            // Pass 2
+            _forEachBlock(
+                [this](const BBTEntry& bbt) { return m_targets.contains(bbt.bref.bid.getBidRaw()); },
+                [this, &onNode](const BBTEntry& bbt, io::Bytes&& bytes) { _addDataBlock(bbt, std::move(bytes), onNode); }
+            );
+
+            std::vector<uint64_t> notRebuilt{};
+            for (const Node& node : m_nodes)
             {
-                DataTree* data = subtree.getDataTree(nid);
-                if (data != nullptr)
+                if (!node.isDone)
                 {
-                    return &data->load(); // Make sure Data Tree is loaded
+                    notRebuilt.push_back(node.key);
                 }
             }
-            return nullptr;
+            STORYT_ERRORIF((!notRebuilt.empty()), "Only [{}] of [{}] nodes were rebuilt", m_nodes.size() - notRebuilt.size(), m_nodes.size());
+            return notRebuilt;
         }
 
-        [[nodiscard]] SubNodeBTree* getNestedSubNodeTree(core::NID nid)
-        {
-            if (m_subtrees.contains(nid.getNIDRaw()))
+    private:
+        struct Node
+        {
+            uint64_t key{ 0 };
+            core::BID bidData{};
+            size_t size{ 0 };
+            size_t nBlocksLeft{ 0 };
+            bool isDone{ false };
+            std::vector<types::byte_t> data{};
+        };
+
+        struct Target
+        {
+            size_t nodeIdx{ 0 };
+            size_t offset{ 0 };
+        };
+
+        struct InternalBlock
+        {
+            uint8_t cLevel{ 0 };
+            std::vector<core::BID> rgbid{};
+        };
+
+        template<typename Pred, typename Callback>
+        void _forEachBlock(Pred&& wanted, Callback&& callback)
+        {
+            const io::ReadScheduler scheduler(MaxGapBytes, m_chunkBytes);
+            std::vector<const BBTEntry*> window{};
+            std::vector<io::ReadRequest> requests{};
+            size_t windowBytes{ 0 };
+            auto flush = [&]() {
+                std::vector<io::Bytes> bytes = scheduler.read(m_source, requests);
+                for (size_t i = 0; i < window.size(); ++i)
+                {
+                    callback(*window[i], std::move(bytes[i]));
+                }
+                window.clear();
+                requests.clear();
+                windowBytes = 0;
+            };
+            for (const BBTEntry& bbt : m_blocks)
             {
-                return &m_subtrees.at(nid.getNIDRaw());
+                if (!wanted(bbt))
+                {
+                    continue;
+                }
+                const auto [blockSize, offset] = DataTree::calcBlockAlignedSize(bbt.cb);
+                if (windowBytes + blockSize > m_chunkBytes && !window.empty())
+                {
+                    flush();
+                }
+                window.push_back(&bbt);
+                requests.push_back({ bbt.bref.ib, blockSize });
+                windowBytes += blockSize;
             }
-            return nullptr;
+            flush();
         }
 
-        [[nodiscard]] const SubNodeBTree* const getNestedSubNodeTree(core::NID nid) const
+        /**
+         * @param childBids = gets the BIDs of an XXBlock's XBlocks that have not been read yet.
+        */
+        void _addInternalBlock(const BBTEntry& bbt, std::span<const types::byte_t> bytes, std::unordered_set<uint64_t>& childBids)
         {
-            if (m_subtrees.contains(nid.getNIDRaw()))
+            // Only a node's bidData is read here so an SLBlock or SIBlock (btype 0x02) means the file is corrupt.
+            // It is left out of m_internalBlocks and the node is reported as not rebuilt.
+            if (bytes[0] != 0x01U)
             {
-                return &m_subtrees.at(nid.getNIDRaw());
+                return;
+            }
+            const bool validate = m_options.shouldValidate(m_options.ndb, bbt.bref.bid.getBidRaw());
+            const uint8_t cLevel = bytes[1];
+            if (cLevel == 0x01U)
+            {
+                m_internalBlocks[bbt.bref.bid.getBidRaw()] = { cLevel, XBlock::Init(bytes, bbt.bref, validate).rgbid };
+            }
+            else if (cLevel == 0x02U)
+            {
+                InternalBlock& xxblock = m_internalBlocks[bbt.bref.bid.getBidRaw()];
+                xxblock = { cLevel, XXBlock::Init(bytes, bbt.bref, validate).rgbid };
+                for (const core::BID& child : xxblock.rgbid)
+                {
+                    if (child.isInternal() && !m_internalBlocks.contains(child.getBidRaw()))
+                    {
+                        childBids.insert(child.getBidRaw());
+                    }
+                }
             }
-            return nullptr;
         }
 
         /**
-         * @brief 
-         * @param dataSize is the size of btype + clevel + cEnt + dwpadding + plus cEnt * Entry Size  
+         * @brief Lists the data blocks of every node in order and records where each block's data goes.
         */
-        static size_t calcBlockAlignedSize(size_t dataSize)
-        {
-            const size_t blockTrailerSize = 16;
-            const size_t totalBlockSizeWithoutPadding = dataSize + blockTrailerSize; // +sBType + sCLevel + sCEnt + sDwPadding;
-
-            const size_t multiple = 64;
-            const size_t remainder = totalBlockSizeWithoutPadding % multiple;
-            const size_t offset = (multiple * (remainder != 0)) - remainder;
-            // The block size is the smallest multiple of 64 that can hold both the data and the block trailer.
-            return totalBlockSizeWithoutPadding + offset;
-        }
-
-    private:
-        void _slBlockToSLEntries(const SLBlock& block) // SL Block to SL Entries
+        void _resolveNodes()
         {
-            for (const SLEntry& slentry : block.entries)
+            for (size_t nodeIdx = 0; nodeIdx < m_nodes.size(); ++nodeIdx)
             {
-                m_slentries.push_back(slentry);
+                Node& node = m_nodes[nodeIdx];
+                std::vector<core::BID> dataBids{};
+                if (!_dataBlocksOf(node.bidData, dataBids))
+                {
+                    STORYT_ERROR("Failed to find the blocks of the DataTree with BID [{}]", node.bidData.getBidRaw());
+                    continue;
+                }
+                for (const core::BID& bid : dataBids)
+                {
+                    m_targets[bid.getBidRaw()].push_back({ nodeIdx, node.size });
+                    node.size += m_blocks[m_blockIdx.at(bid.getBidRaw())].cb;
+                    ++node.nBlocksLeft;
+                }
             }
+            m_internalBlocks.clear();
         }
 
-        void _siBlockToSLEntries(const SIBlock& block) // SI Block to SL Entries
+        bool _dataBlocksOf(core::BID bid, std::vector<core::BID>& dataBids) const
         {
-            std::vector<BBTEntry> entries;
-            entries.reserve(block.entries.size());
-            for (const SIEntry& sientry : block.entries)
+            if (!m_blockIdx.contains(bid.getBidRaw()))
             {
-                const std::optional<BBTEntry> bbt = m_getBBT(sientry.bid);
-                entries.push_back(bbt.value());
+                return false;
             }
-            for (size_t i = 1; i < entries.size(); ++i)
+            if (!bid.isInternal())
             {
-                const size_t start = entries.at(i - 1).bref.ib;
-                const size_t end = entries.at(i).bref.ib;
-                const size_t expectedSize = calcBlockAlignedSize(entries.at(i - 1).bref.ib);
-                STORYT_ASSERT((start < end), "start is not < end");
-                STORYT_ASSERT((end - start == expectedSize), "end - start != expectedSize");
+                dataBids.push_back(bid);
+                return true;
             }
-            size_t nBytes{ 0 };
-            for (const BBTEntry& bbt : entries)
+            const auto it = m_internalBlocks.find(bid.getBidRaw());
+            if (it == m_internalBlocks.end())
             {
-                nBytes += calcBlockAlignedSize(bbt.bref.ib);
+                return false;
             }
-            std::vector<types::byte_t> SLBlocksBytes = _readBlockBytes(entries.at(0).bref.ib, nBytes);
-            utils::ByteView view(SLBlocksBytes);
-            for (const BBTEntry& bbt : entries)
+            for (const core::BID& child : it->second.rgbid)
             {
-                const size_t blockSize = calcBlockAlignedSize(bbt.bref.ib);
-                _slBlockToSLEntries(SLBlock::Init(view.read(blockSize), bbt.bref));
+                // An XXBlock's children are XBlocks and an XBlock's children are data blocks.
+                if (!_dataBlocksOf(child, dataBids))
+                {
+                    return false;
+                }
             }
+            return true;
         }
 
-        std::vector<types::byte_t> _readBlockBytes(uint64_t position, uint64_t totalSize)
-        {
-            return utils::readBytes(m_file.get(), totalSize);
-        }
-
-        std::pair<std::vector<types::byte_t>, BBTEntry> _readBlockBytes(core::BID bid)
+        void _addDataBlock(const BBTEntry& bbt, io::Bytes&& bytes, const OnNode_t& onNode)
         {
-            const std::optional<BBTEntry> bbt = m_getBBT(bid);
-            const size_t totalBlockSize = calcBlockAlignedSize(bbt.value().cb);
-            m_file->seekg(bbt.value().bref.ib, std::ios::beg);
-            return { utils::readBytes(m_file.get(), totalBlockSize), bbt.value() };
+            const bool validate = m_options.shouldValidate(m_options.ndb, bbt.bref.bid.getBidRaw());
+            const DataBlock block = DataBlock::Init(std::move(bytes), bbt.bref, m_cryptMethod, validate);
+            for (const Target& target : m_targets.at(bbt.bref.bid.getBidRaw()))
+            {
+                Node& node = m_nodes[target.nodeIdx];
+                if (node.data.size() != node.size)
+                {
+                    node.data.resize(node.size);
+                }
+                std::copy(block.data().begin(), block.data().end(), node.data.begin() + static_cast<std::ptrdiff_t>(target.offset));
+                if (--node.nBlocksLeft == 0)
+                {
+                    onNode(node.key, std::move(node.data));
+                    node.data = {};
+                    node.isDone = true;
+                }
+            }
         }
 
     private:
-        core::BID m_bid;
-        core::Ref<std::ifstream> m_file;
-        GetBBT_t m_getBBT;
-        std::vector<SLEntry> m_slentries;
-        // uint32_t is a Raw NID
-        std::unordered_map<uint32_t, SubNodeBTree> m_subtrees;
-        // uint32_t is a Raw NID
-        std::unordered_map<uint32_t, DataTree> m_datatrees;
+        const io::BlockSource& m_source;
+        /// Sorted by bref.ib
+        std::vector<BBTEntry> m_blocks;
+        types::CryptMethod m_cryptMethod{ types::CryptMethod::PERMUTE };
+        core::ReadOptions m_options{};
+        size_t m_chunkBytes{ DefaultChunkBytes };
+        /// Raw BID -> index into m_blocks
+        std::unordered_map<uint64_t, size_t> m_blockIdx{};
+        /// Raw BID -> the BIDs an XBlock or XXBlock points at. Only kept between the two passes.
+        std::unordered_map<uint64_t, InternalBlock> m_internalBlocks{};
+        /// Raw BID of a data block -> every place its data is copied to
+        std::unordered_map<uint64_t, std::vector<Target>> m_targets{};
+        std::vector<Node> m_nodes{};
     };
 
     class NDB
     {
     public:
+        /**
+         * @param pageCacheBytes = the most bytes of parsed NBT and BBT pages that are kept in memory.
+         *  Only the two root pages are read up front, every other page is read the first time a lookup reaches it.
+         * @param blockCacheBytes = the most bytes of decoded DataBlocks shared between the DataTrees of this NDB.
+         * @param options = how much of every page, block, heap and object is checked as it is read.
+        */
         NDB(
-            std::ifstream& file,
-            core::Header header
+            const io::BlockSource& source,
+            core::Header header,
+            size_t pageCacheBytes = PageCache::DefaultByteBudget,
+            size_t blockCacheBytes = BlockCache::DefaultByteBudget,
+            core::ReadOptions options = {}
         )
             :
-            m_file(file),
+            m_source(source),
             m_header(header),
+            m_options(options),
             m_rootNBT(InitBTPage(m_header.root.nodeBTreeRootPage, types::PType::NBT)),
-            m_rootBBT(InitBTPage(m_header.root.blockBTreeRootPage, types::PType::BBT))
+            m_rootBBT(InitBTPage(m_header.root.blockBTreeRootPage, types::PType::BBT)),
+            m_pageCache(std::make_unique<PageCache>(pageCacheBytes)),
+            m_blockCache(std::make_unique<BlockCache>(blockCacheBytes)),
+            m_getPage([this](const core::BREF& bref, int32_t parentCLevel) { return this->_getPage(bref, parentCLevel); }),
+            m_readPage([this](const core::BREF& bref, int32_t parentCLevel) { return this->_readPage(bref, parentCLevel); })
         {
             verify();
         }
+        NDB(const NDB&) = delete;
+        NDB& operator=(const NDB&) = delete;
 
+        /**
+         * @brief Every NBT entry that shares nid's nidIndex keyed by its NIDType. For example
+         *  the 4 parts of a folder. The first call builds a nidIndex hash map, every call after that is one hash lookup.
+        */
         [[nodiscard]] std::unordered_map<types::NIDType, NBTEntry> all(core::NID nid) const
 		{
-			return m_rootNBT.all(nid);
+            std::call_once(m_nodeMapsOnce, [this]() { _buildNodeMaps(); });
+            std::unordered_map<types::NIDType, NBTEntry> entries{};
+            const auto it = m_nidIndexMap.find(nid.getNIDIndex());
+            if (it != m_nidIndexMap.end())
+            {
+                for (const NBTEntry& nbt : it->second)
+                {
+                    entries[nbt.nid.getNIDType()] = nbt;
+                }
+            }
+			return entries;
 		}
 
+        /**
+         * @brief The NIDs of every node whose nidParent is parent, sorted by NID. Only the children of
+         *  Folder objects are recorded in the NBT, so for a folder these are its sub folders, messages, FAI messages
+         *  and search nodes. Built in the same pass as the nidIndex map used by all().
+        */
+        [[nodiscard]] const std::vector<core::NID>& children(core::NID parent) const
+        {
+            static const std::vector<core::NID> noChildren{};
+            std::call_once(m_nodeMapsOnce, [this]() { _buildNodeMaps(); });
+            const auto it = m_childrenMap.find(parent.getNIDRaw());
+            return it != m_childrenMap.end() ? it->second : noChildren;
+        }
+
+        [[nodiscard]] std::vector<core::NID> children(core::NID parent, types::NIDType nidType) const
+        {
+            std::vector<core::NID> ret{};
+            for (const core::NID& child : children(parent))
+            {
+                if (child.getNIDType() == nidType)
+                {
+                    ret.push_back(child);
+                }
+            }
+            return ret;
+        }
+
+        [[nodiscard]] size_t nChildren(core::NID parent, types::NIDType nidType) const
+        {
+            const std::vector<core::NID>& all = children(parent);
+            return static_cast<size_t>(std::count_if(all.begin(), all.end(), 
+                [nidType](const core::NID& child) { return child.getNIDType() == nidType; }));
+        }
+
+        /**
+         * @brief Every node below parent, found by following the children of each sub folder. Used to scope
+         *  a scan to one folder subtree without opening any of its hierarchy tables.
+        */
+        [[nodiscard]] std::vector<core::NID> descendants(core::NID parent) const
+        {
+            std::vector<core::NID> ret{};
+            std::unordered_set<uint32_t> visited{ parent.getNIDRaw() };
+            std::vector<core::NID> toVisit{ parent };
+            while (!toVisit.empty())
+            {
+                const core::NID current = toVisit.back();
+                toVisit.pop_back();
+                for (const core::NID& child : children(current))
+                {
+                    // Guards against a corrupt NBT whose nidParents form a cycle.
+                    if (!visited.insert(child.getNIDRaw()).second)
+                    {
+                        continue;
+                    }
+                    ret.push_back(child);
+                    if (child.getNIDType() == types::NIDType::NORMAL_FOLDER)
+                    {
+                        toVisit.push_back(child);
+                    }
+                }
+            }
+            return ret;
+        }
+
         template<typename IDType>
         [[nodiscard]] auto get(IDType id) const
         {
+            const bool isFlattened = m_isFlattened.load(std::memory_order_acquire);
             if constexpr (std::is_same_v<IDType, core::NID>)
             {
-                return m_rootNBT.get<NBTEntry>(id);
+                return isFlattened ? m_nbtIndex.get(id) : m_rootNBT.get<NBTEntry>(id, m_getPage);
             }
             else if constexpr (std::is_same_v<IDType, core::BID>)
             {
-                return m_rootBBT.get<BBTEntry>(id);
+                return isFlattened ? m_bbtIndex.get(id) : m_rootBBT.get<BBTEntry>(id, m_getPage);
             }			
             else
             {
@@ -1215,13 +2611,46 @@ namespace storyt::ndb {
             }
 		}
 
+        /**
+         * @brief Reads every NBT and BBT leaf once and collapses them into an NBTIndex and a BBTIndex.
+         *  After this call get() is a binary search over contiguous arrays and never touches a BTPage.
+         *  Safe to call from several threads, only the first call does the work.
+        */
+        void flattenIndex() const
+        {
+            std::call_once(m_flattenOnce, [this]() {
+                m_nbtIndex = NBTIndex::Init(m_rootNBT, m_readPage);
+                m_bbtIndex = BBTIndex::Init(m_rootBBT, m_readPage);
+                m_isFlattened.store(true, std::memory_order_release);
+            });
+            // Building the node maps from the flat arrays costs no extra I/O.
+            std::call_once(m_nodeMapsOnce, [this]() { _buildNodeMaps(); });
+        }
+
+        [[nodiscard]] bool isIndexFlattened() const
+        {
+            return m_isFlattened.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] const NBTIndex& nbtIndex() const
+        {
+            STORYT_ASSERT(isIndexFlattened(), "flattenIndex() has not been called");
+            return m_nbtIndex;
+        }
+
+        [[nodiscard]] const BBTIndex& bbtIndex() const
+        {
+            STORYT_ASSERT(isIndexFlattened(), "flattenIndex() has not been called");
+            return m_bbtIndex;
+        }
+
         bool verify()
         {
-            STORYT_ASSERT(m_rootNBT.get<NBTEntry>(core::NID_MESSAGE_STORE).has_value(),
+            STORYT_ASSERT(get(core::NID_MESSAGE_STORE).has_value(),
                 "Cannot be more than 1 Message Store");
-            STORYT_ASSERT((m_rootNBT.get<NBTEntry>(core::NID_NAME_TO_ID_MAP).has_value()),
+            STORYT_ASSERT((get(core::NID_NAME_TO_ID_MAP).has_value()),
                 "[ERROR]");
-            STORYT_ASSERT((m_rootNBT.get<NBTEntry>(core::NID_ROOT_FOLDER).has_value()),
+            STORYT_ASSERT((get(core::NID_ROOT_FOLDER).has_value()),
                 "Cannot be more than 1 Root Folder");
             return true;
         }
@@ -1229,10 +2658,13 @@ namespace storyt::ndb {
         [[nodiscard]] DataTree InitDataTree(core::BREF blockBref, size_t sizeofBlockData) const
         {
             return DataTree(
-                core::Ref<std::ifstream>(m_file), 
+                core::Ref<const io::BlockSource>(m_source), 
                 [this](const core::BID& bid) { return this->get(bid); },
                 blockBref, 
-                sizeofBlockData
+                sizeofBlockData,
+                m_header.cryptMethod,
+                m_options,
+                m_blockCache.get()
             );
         }
 
@@ -1240,26 +2672,158 @@ namespace storyt::ndb {
         {
             return SubNodeBTree(
                 bid,
-                core::Ref<std::ifstream>(m_file),
-                [this](const core::BID& bid) { return this->get(bid); }
+                core::Ref<const io::BlockSource>(m_source),
+                [this](const core::BID& bid) { return this->get(bid); },
+                m_header.cryptMethod,
+                m_options,
+                m_blockCache.get()
             );
         }
 
         [[nodiscard]] BTPage InitBTPage(core::BREF bref, types::PType treeType, int32_t parentCLevel = -1)
         {
+            const io::Bytes bytes = m_source.read(bref.ib, BTPage::size);
             return BTPage::Init(
-                utils::readBytes(m_file, bref.ib, BTPage::size),
+                bytes.view(),
                 bref, 
-                m_file,
-                parentCLevel
+                parentCLevel,
+                _validate(bref)
+            );
+        }
+
+        [[nodiscard]] const PageCache& pageCache() const
+        {
+            return *m_pageCache;
+        }
+
+        [[nodiscard]] const BlockCache& blockCache() const
+        {
+            return *m_blockCache;
+        }
+
+        [[nodiscard]] const core::ReadOptions& readOptions() const
+        {
+            return m_options;
+        }
+
+        /**
+         * @brief Every entry of the BBT. Pages are read past the page cache unless the index is flattened.
+        */
+        [[nodiscard]] std::vector<BBTEntry> blockEntries() const
+        {
+            std::vector<BBTEntry> entries{};
+            if (isIndexFlattened())
+            {
+                entries.reserve(m_bbtIndex.size());
+                for (size_t i = 0; i < m_bbtIndex.size(); ++i)
+                {
+                    entries.push_back(m_bbtIndex.at(i));
+                }
+                return entries;
+            }
+            m_rootBBT.forEachLeafEntry(m_readPage, [&entries](const Entry& entry) { entries.push_back(entry.asBBTEntry()); });
+            return entries;
+        }
+
+        /**
+         * @brief Hands the data of every node in the NBT to onNode, reading the file front to back instead of node by node.
+         *  Nodes arrive in the order their last block is reached, not in NID order. See SequentialScan.
+         * @return the nodes whose data could not be rebuilt. onNode is never called for them.
+        */
+        std::vector<NBTEntry> scanNodes(
+            const std::function<void(const NBTEntry&, std::vector<types::byte_t>&&)>& onNode, 
+            size_t chunkBytes = SequentialScan::DefaultChunkBytes
+        ) const
+        {
+            std::vector<NBTEntry> nodes{};
+            m_rootNBT.forEachLeafEntry(m_readPage, [&nodes](const Entry& entry) { nodes.push_back(entry.asNBTEntry()); });
+            SequentialScan scan(m_source, blockEntries(), m_header.cryptMethod, m_options, chunkBytes);
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                scan.addNode(i, nodes[i].bidData);
+            }
+            const std::vector<uint64_t> notRebuilt = scan.run(
+                [&nodes, &onNode](uint64_t key, std::vector<types::byte_t>&& data) { onNode(nodes[key], std::move(data)); }
             );
+            std::vector<NBTEntry> notRebuiltNodes{};
+            notRebuiltNodes.reserve(notRebuilt.size());
+            for (const uint64_t key : notRebuilt)
+            {
+                notRebuiltNodes.push_back(nodes[key]);
+            }
+            return notRebuiltNodes;
+        }
+
+    private:
+        /**
+         * @brief Reads a page straight from the source without going through the page cache.
+         *  Used by full walks of the trees so they do not flush the pages lookups are using.
+        */
+        [[nodiscard]] std::shared_ptr<const BTPage> _readPage(const core::BREF& bref, int32_t parentCLevel) const
+        {
+            const io::Bytes bytes = m_source.read(bref.ib, BTPage::size);
+            return std::make_shared<const BTPage>(BTPage::Init(bytes.view(), bref, parentCLevel, _validate(bref)));
+        }
+
+        void _buildNodeMaps() const
+        {
+            auto add = [this](const NBTEntry& nbt) {
+                std::vector<NBTEntry>& entries = m_nidIndexMap[nbt.nid.getNIDIndex()];
+                for (const NBTEntry& other : entries)
+                {
+                    STORYT_ASSERT((other.nid.getNIDType() != nbt.nid.getNIDType()), "Duplicate NID Type found in NBT");
+                }
+                entries.push_back(nbt);
+                // The root folder is its own parent but not one of its own children.
+                if (nbt.nidParent.getNIDRaw() != 0 && nbt.nidParent.getNIDRaw() != nbt.nid.getNIDRaw())
+                {
+                    // Leaves are visited in NID order so every list of children stays sorted.
+                    m_childrenMap[nbt.nidParent.getNIDRaw()].push_back(nbt.nid);
+                }
+            };
+            if (isIndexFlattened())
+            {
+                for (size_t i = 0; i < m_nbtIndex.size(); ++i)
+                {
+                    add(m_nbtIndex.at(i));
+                }
+                return;
+            }
+            m_rootNBT.forEachLeafEntry(m_readPage, [&add](const Entry& entry) { add(entry.asNBTEntry()); });
+        }
+
+        [[nodiscard]] std::shared_ptr<const BTPage> _getPage(const core::BREF& bref, int32_t parentCLevel) const
+        {
+            return m_pageCache->get(bref.ib, [this, &bref, parentCLevel]() {
+                const io::Bytes bytes = m_source.read(bref.ib, BTPage::size);
+                return BTPage::Init(bytes.view(), bref, parentCLevel, _validate(bref));
+            });
+        }
+
+        [[nodiscard]] bool _validate(core::BREF bref) const
+        {
+            return m_options.shouldValidate(m_options.ndb, bref.bid.getBidRaw());
         }
 
     private:
-        std::ifstream& m_file;
+        const io::BlockSource& m_source;
         core::Header m_header;
+        core::ReadOptions m_options;
         BTPage m_rootNBT;
         BTPage m_rootBBT;
+        std::unique_ptr<PageCache> m_pageCache;
+        std::unique_ptr<BlockCache> m_blockCache;
+        BTPage::GetPage_t m_getPage;
+        BTPage::GetPage_t m_readPage;
+        mutable std::once_flag m_flattenOnce{};
+        mutable std::atomic<bool> m_isFlattened{ false };
+        mutable NBTIndex m_nbtIndex{};
+        mutable BBTIndex m_bbtIndex{};
+        mutable std::once_flag m_nodeMapsOnce{};
+        /// nidIndex -> the NBT entries of every NIDType that share it
+        mutable std::unordered_map<uint32_t, std::vector<NBTEntry>> m_nidIndexMap{};
+        /// nidParent -> the NIDs of its children
+        mutable std::unordered_map<uint32_t, std::vector<core::NID>> m_childrenMap{};
     };
 }
 
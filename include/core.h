@@ -39,8 +39,8 @@ namespace storyt::core {
         {
 			_init();
 		}
-        explicit BID(const std::vector<types::byte_t>& bytes)
-            : m_bid(utils::toT_l<decltype(m_bid)>(bytes)) 
+        explicit BID(std::span<const types::byte_t> bytes)
+            : m_bid(utils::loadLE<decltype(m_bid)>(bytes)) 
         {
 			_init();
         }
@@ -122,7 +122,7 @@ namespace storyt::core {
     public:
         NID() = default;
         constexpr explicit NID(uint32_t _nid) : m_nid(_nid) {}
-        explicit NID(const std::vector<types::byte_t>& bytes) 
+        explicit NID(std::span<const types::byte_t> bytes) 
         {
             utils::ByteView view(bytes);
             m_nid = view.read<uint32_t>(4);
@@ -220,7 +220,7 @@ namespace storyt::core {
 
         BREF() = default;
 
-        explicit BREF(const std::vector<types::byte_t>& bytes)
+        explicit BREF(std::span<const types::byte_t> bytes)
         {
             STORYT_ASSERT((bytes.size() == 16), "BREF must be 16 bytes not [{}]", bytes.size());
             utils::ByteView view(bytes);
@@ -338,9 +338,62 @@ namespace storyt::core {
     struct Header
     {
         const Root root;
+        /// How every data block in the file is encoded.
+        const types::CryptMethod cryptMethod{ types::CryptMethod::PERMUTE };
 
-        explicit Header(Root&& root)
-            : root(root) {}
+        explicit Header(Root&& root, types::CryptMethod cryptMethod_ = types::CryptMethod::PERMUTE)
+            : root(root), cryptMethod(cryptMethod_) {}
+    };
+
+    /**
+     * @brief How much of the on disk structure is checked as it is read.
+     *  Full = every structure is checked (the default).
+     *  Sampled = roughly 1 in sampleRate structures are checked. Which ones is decided by their BID/NID,
+     *      so reading the same structure twice makes the same choice.
+     *  Trusted = nothing is checked. Only use this for files that have already been read once with Full.
+    */
+    enum class Validation : uint8_t
+    {
+        Full,
+        Sampled,
+        Trusted
+    };
+
+    /**
+     * @brief The validation level of each layer of the read path.
+     * @param ndb = block CRCs, block trailer and page trailer signatures.
+     * @param ltp = heap fill levels and page maps and the Property/Table Context schema checks.
+     * @param messaging = the Folder, Message Store, Message and Attachment schema checks.
+    */
+    struct ReadOptions
+    {
+        Validation ndb{ Validation::Full };
+        Validation ltp{ Validation::Full };
+        Validation messaging{ Validation::Full };
+        uint32_t sampleRate{ 16 };
+
+        [[nodiscard]] static ReadOptions Trusted()
+        {
+            return ReadOptions{ Validation::Trusted, Validation::Trusted, Validation::Trusted };
+        }
+
+        /**
+         * @param id = the BID or NID of the structure about to be read.
+        */
+        [[nodiscard]] bool shouldValidate(Validation level, uint64_t id) const
+        {
+            switch (level)
+            {
+            case Validation::Full:
+                return true;
+            case Validation::Trusted:
+                return false;
+            case Validation::Sampled:
+                // Fibonacci hashing spreads the sequential BIDs/NIDs evenly over the samples.
+                return sampleRate <= 1 || ((id * 0x9E3779B97F4A7C15ULL) >> 32U) % sampleRate == 0;
+            }
+            return true;
+        }
     };
 
     template<typename T>
@@ -348,8 +401,8 @@ namespace storyt::core {
     {
     public :
         explicit Ref(T& t) : m_ref(t) {}
-        T* operator->() { return &m_ref.get(); }
-        T& get() { return m_ref.get(); }
+        T* operator->() const { return &m_ref.get(); }
+        T& get() const { return m_ref.get(); }
     private:
         std::reference_wrapper<T> m_ref;
     };
@@ -0,0 +1,806 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <string>
+#include <memory>
+#include <span>
+#include <utility>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #if defined(__linux__) && __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #include <sys/syscall.h>
+        #include <sched.h>
+        #define STORYT_IO_URING_ 1
+    #endif
+#endif
+
+#include "types.h"
+#include "utils.h"
+
+#ifndef STORYT_IO_H
+#define STORYT_IO_H
+
+namespace storyt::io {
+
+    enum class SourceType
+    {
+        /// Every read is a positional read (pread/ReadFile with an offset) into a new buffer.
+        PositionalRead,
+        /// The whole file is mapped into the address space once and reads
+        /// return views into the mapping.
+        MemoryMapped,
+        /// Single reads are positional reads but every batch of reads is submitted to an io_uring
+        /// at once so the device works on all of them together. Falls back to PositionalRead 
+        /// when io_uring is not available.
+        IOUring
+    };
+
+    struct ReadRequest
+    {
+        uint64_t position{ 0 };
+        size_t nBytes{ 0 };
+    };
+
+    /**
+    * @brief The bytes returned by a BlockSource. When the source is memory mapped the bytes
+    *  point straight into the mapping and nothing is copied. Otherwise the bytes are owned.
+    *  A borrowed Bytes is only valid for as long as the BlockSource that returned it.
+    */
+    class Bytes
+    {
+    public:
+        Bytes() = default;
+        explicit Bytes(std::span<const types::byte_t> borrowed)
+            : m_data(borrowed.data()), m_size(borrowed.size()) {}
+        explicit Bytes(std::vector<types::byte_t>&& owned)
+            : m_owned(std::move(owned)), m_size(m_owned.size()), m_isOwned(true) {}
+
+        [[nodiscard]] std::span<const types::byte_t> view() const
+        {
+            if (m_isOwned)
+            {
+                return { m_owned.data(), m_owned.size() };
+            }
+            return { m_data, m_size };
+        }
+
+        /**
+         * @brief Copies the bytes out unless they are already owned, in which case they are moved out.
+        */
+        [[nodiscard]] std::vector<types::byte_t> toVector() &&
+        {
+            if (m_isOwned)
+            {
+                return std::move(m_owned);
+            }
+            return { m_data, m_data + m_size };
+        }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+        [[nodiscard]] bool isOwned() const { return m_isOwned; }
+
+    private:
+        std::vector<types::byte_t> m_owned{};
+        const types::byte_t* m_data{ nullptr };
+        size_t m_size{ 0 };
+        bool m_isOwned{ false };
+    };
+
+    /**
+    * @brief A read only view of the PST file. Every read is addressed by its absolute file offset
+    *  and implementations keep no shared cursor, so a single BlockSource can be read from by
+    *  any number of threads at the same time without locking.
+    */
+    class BlockSource
+    {
+    public:
+        virtual ~BlockSource() = default;
+
+        /**
+         * @brief Reads nBytes starting at the absolute file offset position.
+         * @throws std::system_error when the read fails or does not return all nBytes.
+        */
+        [[nodiscard]] virtual Bytes read(uint64_t position, size_t nBytes) const = 0;
+
+        /**
+         * @brief Reads every request and returns their bytes in the same order. By default the reads
+         *  are issued one after another, sources that can keep several reads in flight override this.
+        */
+        [[nodiscard]] virtual std::vector<Bytes> readBatch(std::span<const ReadRequest> requests) const
+        {
+            std::vector<Bytes> res{};
+            res.reserve(requests.size());
+            for (const ReadRequest& request : requests)
+            {
+                res.push_back(read(request.position, request.nBytes));
+            }
+            return res;
+        }
+        [[nodiscard]] virtual uint64_t size() const = 0;
+        [[nodiscard]] virtual SourceType type() const = 0;
+
+        /**
+         * @throws std::system_error when the file can not be opened or mapped.
+        */
+        static std::unique_ptr<BlockSource> Init(const std::string& path, SourceType type);
+
+    protected:
+        /**
+         * @brief Throws std::system_error(invalid_argument) when [position, position + nBytes) is not inside size.
+        */
+        static void _checkInBounds(uint64_t position, size_t nBytes, uint64_t size)
+        {
+            if (position > size || nBytes > size - position)
+            {
+                throw std::system_error(std::make_error_code(std::errc::invalid_argument), 
+                    "Read of [" + std::to_string(nBytes) + "] bytes at [" + std::to_string(position) + 
+                    "] is past the end of the file [" + std::to_string(size) + "]");
+            }
+        }
+
+        /**
+         * @brief Throws the error the last failed system call left behind.
+        */
+        [[noreturn]] static void _throwLastError(const std::string& what)
+        {
+#if defined(_WIN32)
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+            throw std::system_error(errno, std::generic_category(), what);
+#endif
+        }
+    };
+
+    class PositionalReadSource : public BlockSource
+    {
+    public:
+        explicit PositionalReadSource(const std::string& path)
+        {
+            _open(path);
+        }
+        PositionalReadSource(const PositionalReadSource&) = delete;
+        PositionalReadSource(PositionalReadSource&&) = delete;
+        PositionalReadSource& operator=(const PositionalReadSource&) = delete;
+        PositionalReadSource& operator=(PositionalReadSource&&) = delete;
+
+        ~PositionalReadSource() override
+        {
+            _close();
+        }
+
+        [[nodiscard]] Bytes read(uint64_t position, size_t nBytes) const override
+        {
+            _checkInBounds(position, nBytes, m_size);
+            std::vector<types::byte_t> res(nBytes, '\0');
+            size_t nRead{ 0 };
+            while (nRead < nBytes)
+            {
+                const int64_t n = _readAt(position + nRead, res.data() + nRead, nBytes - nRead);
+                if (n < 0)
+                {
+                    _throwLastError("Failed to read [" + std::to_string(nBytes - nRead) + "] bytes at [" + std::to_string(position + nRead) + "]");
+                }
+                if (n == 0) // The file is shorter than it was when it was opened
+                {
+                    throw std::system_error(std::make_error_code(std::errc::io_error), 
+                        "Read [" + std::to_string(nRead) + "] of [" + std::to_string(nBytes) + "] bytes at [" + std::to_string(position) + "]");
+                }
+                nRead += static_cast<size_t>(n);
+            }
+            return Bytes(std::move(res));
+        }
+
+        [[nodiscard]] uint64_t size() const override { return m_size; }
+        [[nodiscard]] SourceType type() const override { return SourceType::PositionalRead; }
+
+    protected:
+#if defined(_WIN32)
+        void _open(const std::string& path)
+        {
+            m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+            if (m_fileHandle == INVALID_HANDLE_VALUE)
+            {
+                _throwLastError("Failed to open file [" + path + "]");
+            }
+
+            LARGE_INTEGER fileSize{};
+            if (!GetFileSizeEx(m_fileHandle, &fileSize))
+            {
+                // The destructor does not run when the constructor throws.
+                const DWORD error = GetLastError();
+                _close();
+                throw std::system_error(static_cast<int>(error), std::system_category(), "Failed to get the size of [" + path + "]");
+            }
+            m_size = static_cast<uint64_t>(fileSize.QuadPart);
+        }
+
+        void _close()
+        {
+            if (m_fileHandle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_fileHandle);
+            }
+        }
+
+        int64_t _readAt(uint64_t position, types::byte_t* out, size_t nBytes) const
+        {
+            // The offset lives in the OVERLAPPED struct so no file pointer is shared between threads.
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFULL);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32U);
+            DWORD nRead{ 0 };
+            const DWORD toRead = static_cast<DWORD>(std::min<size_t>(nBytes, 0x7FFFFFFFU));
+            if (!ReadFile(m_fileHandle, out, toRead, &nRead, &overlapped))
+            {
+                return -1;
+            }
+            return static_cast<int64_t>(nRead);
+        }
+
+        HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
+#else
+        void _open(const std::string& path)
+        {
+            m_fd = ::open(path.c_str(), O_RDONLY);
+            if (m_fd == -1)
+            {
+                _throwLastError("Failed to open file [" + path + "]");
+            }
+
+            struct stat info {};
+            if (::fstat(m_fd, &info) != 0)
+            {
+                // The destructor does not run when the constructor throws.
+                const int error = errno;
+                _close();
+                throw std::system_error(error, std::generic_category(), "Failed to stat [" + path + "]");
+            }
+            m_size = static_cast<uint64_t>(info.st_size);
+        }
+
+        void _close()
+        {
+            if (m_fd != -1)
+            {
+                ::close(m_fd);
+            }
+        }
+
+        int64_t _readAt(uint64_t position, types::byte_t* out, size_t nBytes) const
+        {
+            return static_cast<int64_t>(::pread(m_fd, out, nBytes, static_cast<off_t>(position)));
+        }
+
+        int m_fd{ -1 };
+#endif
+        uint64_t m_size{ 0 };
+    };
+
+    class MappedSource : public BlockSource
+    {
+    public:
+        explicit MappedSource(const std::string& path)
+        {
+            _map(path);
+        }
+        MappedSource(const MappedSource&) = delete;
+        MappedSource(MappedSource&&) = delete;
+        MappedSource& operator=(const MappedSource&) = delete;
+        MappedSource& operator=(MappedSource&&) = delete;
+
+        ~MappedSource() override
+        {
+            _unmap();
+        }
+
+        [[nodiscard]] Bytes read(uint64_t position, size_t nBytes) const override
+        {
+            _checkInBounds(position, nBytes, m_size);
+            return Bytes(std::span<const types::byte_t>(m_data + position, nBytes));
+        }
+
+        [[nodiscard]] uint64_t size() const override { return m_size; }
+        [[nodiscard]] SourceType type() const override { return SourceType::MemoryMapped; }
+
+    private:
+#if defined(_WIN32)
+        void _map(const std::string& path)
+        {
+            m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+            if (m_fileHandle == INVALID_HANDLE_VALUE)
+            {
+                _throwLastError("Failed to open file [" + path + "]");
+            }
+
+            LARGE_INTEGER fileSize{};
+            const bool isSized = GetFileSizeEx(m_fileHandle, &fileSize);
+            m_size = static_cast<uint64_t>(fileSize.QuadPart);
+            if (isSized)
+            {
+                m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            }
+            if (m_mappingHandle != nullptr)
+            {
+                m_data = static_cast<const types::byte_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            }
+            if (m_data == nullptr)
+            {
+                // The destructor does not run when the constructor throws.
+                const DWORD error = GetLastError();
+                _unmap();
+                throw std::system_error(static_cast<int>(error), std::system_category(), "Failed to map file [" + path + "]");
+            }
+        }
+
+        void _unmap()
+        {
+            if (m_data != nullptr)
+            {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mappingHandle != nullptr)
+            {
+                CloseHandle(m_mappingHandle);
+            }
+            if (m_fileHandle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_fileHandle);
+            }
+        }
+
+        HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
+        HANDLE m_mappingHandle{ nullptr };
+#else
+        void _map(const std::string& path)
+        {
+            m_fd = ::open(path.c_str(), O_RDONLY);
+            if (m_fd == -1)
+            {
+                _throwLastError("Failed to open file [" + path + "]");
+            }
+
+            struct stat info {};
+            void* addr = MAP_FAILED;
+            if (::fstat(m_fd, &info) == 0)
+            {
+                m_size = static_cast<uint64_t>(info.st_size);
+                addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+            }
+            if (addr == MAP_FAILED)
+            {
+                // The destructor does not run when the constructor throws.
+                const int error = errno;
+                _unmap();
+                throw std::system_error(error, std::generic_category(), "Failed to map file [" + path + "]");
+            }
+            m_data = static_cast<const types::byte_t*>(addr);
+            // Node and block lookups jump all over the file.
+            ::madvise(addr, m_size, MADV_RANDOM);
+        }
+
+        void _unmap()
+        {
+            if (m_data != nullptr)
+            {
+                ::munmap(const_cast<types::byte_t*>(m_data), m_size);
+            }
+            if (m_fd != -1)
+            {
+                ::close(m_fd);
+            }
+        }
+
+        int m_fd{ -1 };
+#endif
+        const types::byte_t* m_data{ nullptr };
+        uint64_t m_size{ 0 };
+    };
+
+#if defined(STORYT_IO_URING_)
+    /**
+    * @brief A minimal io_uring built straight on the syscalls so there is no dependency on liburing.
+    *  It is not thread safe, IOUringSource serializes access to it.
+    */
+    class IOUring
+    {
+    public:
+        explicit IOUring(uint32_t nEntries)
+        {
+            io_uring_params params{};
+            const long fd = ::syscall(__NR_io_uring_setup, nEntries, &params);
+            if (fd < 0) // Not supported by the kernel or blocked by a seccomp filter
+            {
+                return;
+            }
+            m_ringFd = static_cast<int>(fd);
+            m_sqBytes = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            m_cqBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMmap)
+            {
+                m_sqBytes = m_cqBytes = std::max(m_sqBytes, m_cqBytes);
+            }
+            m_sq = _map(m_sqBytes, IORING_OFF_SQ_RING);
+            m_cq = singleMmap ? m_sq : _map(m_cqBytes, IORING_OFF_CQ_RING);
+            m_sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+            m_sqes = static_cast<io_uring_sqe*>(_map(m_sqesBytes, IORING_OFF_SQES));
+            if (m_sq == nullptr || m_cq == nullptr || m_sqes == nullptr)
+            {
+                return;
+            }
+            m_nEntries = params.sq_entries;
+            m_sqTail = _at<uint32_t>(m_sq, params.sq_off.tail);
+            m_sqMask = *_at<uint32_t>(m_sq, params.sq_off.ring_mask);
+            m_sqArray = _at<uint32_t>(m_sq, params.sq_off.array);
+            m_cqHead = _at<uint32_t>(m_cq, params.cq_off.head);
+            m_cqTail = _at<uint32_t>(m_cq, params.cq_off.tail);
+            m_cqMask = *_at<uint32_t>(m_cq, params.cq_off.ring_mask);
+            m_cqes = _at<io_uring_cqe>(m_cq, params.cq_off.cqes);
+            m_isReady = true;
+        }
+        IOUring(const IOUring&) = delete;
+        IOUring& operator=(const IOUring&) = delete;
+
+        ~IOUring()
+        {
+            if (m_sqes != nullptr)
+            {
+                ::munmap(m_sqes, m_sqesBytes);
+            }
+            if (m_cq != nullptr && m_cq != m_sq)
+            {
+                ::munmap(m_cq, m_cqBytes);
+            }
+            if (m_sq != nullptr)
+            {
+                ::munmap(m_sq, m_sqBytes);
+            }
+            if (m_ringFd != -1)
+            {
+                ::close(m_ringFd);
+            }
+        }
+
+        [[nodiscard]] bool isReady() const { return m_isReady; }
+
+        /**
+         * @brief Reads every request from fd into out, at most one ring's worth in flight at a time.
+         * @param results = the number of bytes each read returned or -errno.
+         * @return false when the ring itself failed. The ring is not used again after that. Every read that
+         *  was submitted has still completed by then so out can be freed.
+        */
+        bool read(int fd, std::span<const ReadRequest> requests, std::vector<std::vector<types::byte_t>>& out, std::vector<int64_t>& results)
+        {
+            for (size_t first = 0; m_isReady && first < requests.size(); first += m_nEntries)
+            {
+                const size_t n = std::min<size_t>(m_nEntries, requests.size() - first);
+                uint32_t tail = *m_sqTail;
+                for (size_t i = first; i < first + n; ++i)
+                {
+                    const uint32_t idx = tail & m_sqMask;
+                    io_uring_sqe& sqe = m_sqes[idx];
+                    std::memset(&sqe, 0, sizeof(sqe));
+                    sqe.opcode = IORING_OP_READ;
+                    sqe.fd = fd;
+                    sqe.addr = reinterpret_cast<uint64_t>(out[i].data());
+                    sqe.len = static_cast<uint32_t>(requests[i].nBytes);
+                    sqe.off = requests[i].position;
+                    sqe.user_data = i;
+                    m_sqArray[idx] = idx;
+                    ++tail;
+                }
+                std::atomic_ref<uint32_t>(*m_sqTail).store(tail, std::memory_order_release);
+                m_isReady = _submitAndWait(static_cast<uint32_t>(n), results);
+            }
+            return m_isReady;
+        }
+
+    private:
+        bool _submitAndWait(uint32_t nSubmit, std::vector<int64_t>& results)
+        {
+            uint32_t nToSubmit = nSubmit;
+            uint32_t nDone{ 0 };
+            while (nDone < nSubmit)
+            {
+                const long ret = ::syscall(__NR_io_uring_enter, m_ringFd, nToSubmit, nSubmit - nDone, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR)
+                {
+                    // The reads that were submitted are still writing into the caller's buffers.
+                    _drain(nSubmit - nToSubmit - nDone, results);
+                    return false;
+                }
+                if (ret > 0)
+                {
+                    nToSubmit -= std::min<uint32_t>(nToSubmit, static_cast<uint32_t>(ret));
+                }
+                nDone += _reap(results);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Waits until nInFlight more reads have completed. Never gives up because a read that is
+         *  left behind would write into memory that has been freed.
+        */
+        void _drain(uint32_t nInFlight, std::vector<int64_t>& results)
+        {
+            while (nInFlight > 0)
+            {
+                const long ret = ::syscall(__NR_io_uring_enter, m_ringFd, 0, nInFlight, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR)
+                {
+                    // Completions are still posted to the CQ ring, every return to user space lets the kernel post them.
+                    ::sched_yield();
+                }
+                nInFlight -= std::min(nInFlight, _reap(results));
+            }
+        }
+
+        /**
+         * @brief Moves every completion in the CQ ring into results.
+         * @return the number of completions.
+        */
+        uint32_t _reap(std::vector<int64_t>& results)
+        {
+            uint32_t nReaped{ 0 };
+            uint32_t head = *m_cqHead;
+            const uint32_t tail = std::atomic_ref<uint32_t>(*m_cqTail).load(std::memory_order_acquire);
+            for (; head != tail; ++head, ++nReaped)
+            {
+                const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                results[cqe.user_data] = cqe.res;
+            }
+            std::atomic_ref<uint32_t>(*m_cqHead).store(head, std::memory_order_release);
+            return nReaped;
+        }
+
+        void* _map(size_t nBytes, uint64_t offset) const
+        {
+            void* addr = ::mmap(nullptr, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, static_cast<off_t>(offset));
+            return addr == MAP_FAILED ? nullptr : addr;
+        }
+
+        template<typename T>
+        static T* _at(void* base, uint32_t offset)
+        {
+            return reinterpret_cast<T*>(static_cast<types::byte_t*>(base) + offset);
+        }
+
+    private:
+        int m_ringFd{ -1 };
+        bool m_isReady{ false };
+        uint32_t m_nEntries{ 0 };
+        size_t m_sqBytes{ 0 };
+        size_t m_cqBytes{ 0 };
+        size_t m_sqesBytes{ 0 };
+        void* m_sq{ nullptr };
+        void* m_cq{ nullptr };
+        io_uring_sqe* m_sqes{ nullptr };
+        uint32_t* m_sqTail{ nullptr };
+        uint32_t m_sqMask{ 0 };
+        uint32_t* m_sqArray{ nullptr };
+        uint32_t* m_cqHead{ nullptr };
+        uint32_t* m_cqTail{ nullptr };
+        uint32_t m_cqMask{ 0 };
+        io_uring_cqe* m_cqes{ nullptr };
+    };
+
+    /**
+    * @brief A PositionalReadSource whose batches go through one io_uring so every sibling block read is
+    *  in flight at the same time. Single reads stay plain preads. Reads the ring could not finish,
+    *  short reads included, are redone with pread, and when the ring can not be set up every batch is.
+    */
+    class IOUringSource : public PositionalReadSource
+    {
+    public:
+        static constexpr uint32_t RingEntries = 64;
+
+    public:
+        explicit IOUringSource(const std::string& path)
+            : PositionalReadSource(path), m_ring(std::make_unique<IOUring>(RingEntries)) {}
+
+        [[nodiscard]] std::vector<Bytes> readBatch(std::span<const ReadRequest> requests) const override
+        {
+            if (requests.size() < 2)
+            {
+                return PositionalReadSource::readBatch(requests);
+            }
+            std::vector<std::vector<types::byte_t>> buffers(requests.size());
+            std::vector<int64_t> results(requests.size(), -1);
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                buffers[i].resize(requests[i].nBytes);
+            }
+            {
+                const std::lock_guard<std::mutex> lock(m_ringMutex);
+                if (m_ring->isReady())
+                {
+                    m_ring->read(m_fd, requests, buffers, results);
+                }
+            }
+            std::vector<Bytes> res{};
+            res.reserve(requests.size());
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                if (results[i] == static_cast<int64_t>(requests[i].nBytes))
+                {
+                    res.emplace_back(std::move(buffers[i]));
+                }
+                else
+                {
+                    res.push_back(read(requests[i].position, requests[i].nBytes));
+                }
+            }
+            return res;
+        }
+
+        [[nodiscard]] SourceType type() const override { return SourceType::IOUring; }
+
+        /**
+         * @brief False when io_uring is unavailable and every batch falls back to pread.
+        */
+        [[nodiscard]] bool usesIOUring() const
+        {
+            const std::lock_guard<std::mutex> lock(m_ringMutex);
+            return m_ring->isReady();
+        }
+
+    private:
+        std::unique_ptr<IOUring> m_ring;
+        mutable std::mutex m_ringMutex{};
+    };
+#endif
+
+    /**
+    * @brief Turns a set of pending reads into as few reads as possible. The reads are sorted by position and
+    *  any that overlap, touch or are at most maxGap bytes apart are merged, as long as a merged read stays under
+    *  maxRead bytes. The merged reads are issued as one readBatch and split back up in the order they were requested.
+    *  A memory mapped source never copies so its reads are passed straight through.
+    */
+    class ReadScheduler
+    {
+    public:
+        /// Reading a gap this small costs less than the extra syscall and seek it saves.
+        static constexpr size_t DefaultMaxGap = 4096;
+        static constexpr size_t DefaultMaxRead = 1024ULL * 1024ULL;
+
+    public:
+        explicit ReadScheduler(size_t maxGap = DefaultMaxGap, size_t maxRead = DefaultMaxRead)
+            : m_maxGap(maxGap), m_maxRead(maxRead) {}
+
+        /**
+         * @return the merged reads sorted by position.
+        */
+        [[nodiscard]] std::vector<ReadRequest> plan(std::span<const ReadRequest> requests) const
+        {
+            std::vector<size_t> mergedIdx{};
+            return _plan(requests, mergedIdx);
+        }
+
+        [[nodiscard]] std::vector<Bytes> read(const BlockSource& source, std::span<const ReadRequest> requests) const
+        {
+            if (source.type() == SourceType::MemoryMapped || requests.size() < 2)
+            {
+                return source.readBatch(requests);
+            }
+            std::vector<size_t> mergedIdx{};
+            const std::vector<ReadRequest> merged = _plan(requests, mergedIdx);
+            if (merged.size() == requests.size())
+            {
+                return source.readBatch(requests);
+            }
+            std::vector<Bytes> mergedBytes = source.readBatch(merged);
+            std::vector<size_t> nRequestsPerRead(merged.size(), 0);
+            for (const size_t m : mergedIdx)
+            {
+                ++nRequestsPerRead[m];
+            }
+
+            std::vector<Bytes> res(requests.size());
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                const ReadRequest& request = requests[i];
+                const size_t m = mergedIdx[i];
+                if (nRequestsPerRead[m] == 1)
+                {
+                    // Nothing was merged into this read so it is handed over as is.
+                    res[i] = std::move(mergedBytes[m]);
+                    continue;
+                }
+                const std::span<const types::byte_t> view = 
+                    mergedBytes[m].view().subspan(static_cast<size_t>(request.position - merged[m].position), request.nBytes);
+                // Once the merged read is freed its bytes are gone so each read gets its own copy.
+                res[i] = Bytes(std::vector<types::byte_t>(view.begin(), view.end()));
+            }
+            return res;
+        }
+
+    private:
+        /**
+         * @param mergedIdx = filled with the index of the merged read that covers each request.
+        */
+        [[nodiscard]] std::vector<ReadRequest> _plan(std::span<const ReadRequest> requests, std::vector<size_t>& mergedIdx) const
+        {
+            std::vector<ReadRequest> merged{};
+            mergedIdx.assign(requests.size(), 0);
+            for (const size_t i : _sortedByPosition(requests))
+            {
+                const ReadRequest& request = requests[i];
+                if (!merged.empty() && _canMerge(merged.back(), request))
+                {
+                    ReadRequest& last = merged.back();
+                    last.nBytes = static_cast<size_t>(std::max(last.position + last.nBytes, request.position + request.nBytes) - last.position);
+                }
+                else
+                {
+                    merged.push_back(request);
+                }
+                mergedIdx[i] = merged.size() - 1;
+            }
+            return merged;
+        }
+
+        [[nodiscard]] bool _canMerge(const ReadRequest& last, const ReadRequest& next) const
+        {
+            const uint64_t lastEnd = last.position + last.nBytes;
+            const uint64_t mergedEnd = std::max(lastEnd, next.position + next.nBytes);
+            return next.position <= lastEnd + m_maxGap && mergedEnd - last.position <= m_maxRead;
+        }
+
+        [[nodiscard]] static std::vector<size_t> _sortedByPosition(std::span<const ReadRequest> requests)
+        {
+            std::vector<size_t> order(requests.size());
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&requests](size_t lhs, size_t rhs) {
+                return requests[lhs].position < requests[rhs].position;
+            });
+            return order;
+        }
+
+    private:
+        size_t m_maxGap{ DefaultMaxGap };
+        size_t m_maxRead{ DefaultMaxRead };
+    };
+
+    std::unique_ptr<BlockSource> BlockSource::Init(const std::string& path, SourceType type)
+    {
+        if (type == SourceType::MemoryMapped)
+        {
+            return std::make_unique<MappedSource>(path);
+        }
+#if defined(STORYT_IO_URING_)
+        if (type == SourceType::IOUring)
+        {
+            return std::make_unique<IOUringSource>(path);
+        }
+#endif
+        return std::make_unique<PositionalReadSource>(path);
+    }
+
+} // namespace storyt::io
+
+#endif // !STORYT_IO_H
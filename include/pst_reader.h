@@ -8,6 +8,7 @@
 #include "utils.h"
 #include "types.h"
 #include "core.h"
+#include "io.h"
 #include "NDB.h"
 #include "LTP.h"
 #include "Messaging.h"
@@ -22,22 +23,39 @@ namespace storyt
     class PSTReader
     {
     public:
-        explicit PSTReader(std::string path) 
-            : m_path(std::move(path)) {}
-        ~PSTReader()
+        /**
+         * @param options = how much of the file is checked as it is read. The default checks everything.
+         *  core::ReadOptions::Trusted() skips every check and is meant for files that have already been read once.
+        */
+        explicit PSTReader(std::string path, core::ReadOptions options = {}) 
+            : m_path(std::move(path)), m_options(options) {}
+
+        /**
+         * @param sourceType = how the file is read. io::SourceType::MemoryMapped maps the whole file once
+         *  and the NDB parses its pages and blocks straight out of the mapping. io::SourceType::IOUring
+         *  reads the sibling blocks of X/XX and SI blocks together in one io_uring batch.
+         * @param pageCacheBytes = the byte budget of the NDB's NBT/BBT page cache.
+         * @param blockCacheBytes = the byte budget of the NDB's decoded block cache.
+         * @throws std::system_error when the file can not be opened or mapped.
+        */
+        void read(
+            io::SourceType sourceType = io::SourceType::PositionalRead, 
+            size_t pageCacheBytes = ndb::PageCache::DefaultByteBudget,
+            size_t blockCacheBytes = ndb::BlockCache::DefaultByteBudget
+        )
         {
-            if (m_file.is_open())
-            {
-                m_file.close();
-            }
+            _open(sourceType);
+            m_ndb.reset(new ndb::NDB(*m_source, _readHeader(*m_source), pageCacheBytes, blockCacheBytes, m_options));
+            m_ltp.reset(new ltp::LTP(core::Ref<const ndb::NDB>{*m_ndb}));
+            m_msg.reset(new Messaging(core::Ref<const ndb::NDB>{*m_ndb}, core::Ref<const ltp::LTP>{*m_ltp}));
         }
 
-        void read()
+        /**
+         * @brief Collapses the NBT and BBT into flat sorted arrays. See ndb::NDB::flattenIndex.
+        */
+        void flattenIndex()
         {
-            _open();
-            m_ndb.reset(new ndb::NDB(m_file, _readHeader(m_file)));
-            m_ltp.reset(new ltp::LTP(core::Ref<const ndb::NDB>{*m_ndb}));
-            m_msg.reset(new Messaging(core::Ref<const ndb::NDB>{*m_ndb}, core::Ref<const ltp::LTP>{*m_ltp}));
+            m_ndb->flattenIndex();
         }
 
         template<typename FolderID>
@@ -47,18 +65,15 @@ namespace storyt
         }
 
     private:
-        void _open()
+        void _open(io::SourceType sourceType)
         {
-            m_file.open(m_path, std::ios::binary);
-            STORYT_ASSERT(m_file.is_open(), "Failed to open file [{}]", m_path.c_str());
+            m_source = io::BlockSource::Init(m_path, sourceType);
         }
 
-        core::Header _readHeader(std::ifstream& file)
+        core::Header _readHeader(const io::BlockSource& source)
         {
-            STORYT_ASSERT((file.fail() == false), "Failed to read file [{}]", m_path.c_str());
-            file.seekg(0);
-            STORYT_ASSERT((file.fail() == false), "Failed to open file [{}]", m_path.c_str());
-            const std::vector<types::byte_t> bytes = utils::readBytes(file, 564);
+            STORYT_ASSERT((source.size() >= 564), "File [{}] is too small to be a PST", m_path.c_str());
+            const std::vector<types::byte_t> bytes = source.read(0, 564).toVector();
 
             /**
              * dwMagic (4 bytes): MUST be { 0x21, 0x42, 0x44, 0x4E }
@@ -234,7 +249,7 @@ namespace storyt
            */
            const uint8_t bCryptMethod = utils::slice(bytes, 513, 514, 1, utils::toT_l<uint8_t>);
            STORYT_ASSERT( (utils::isIn(bCryptMethod, { 0, 1, 2, 0x10 })) , "Invalid Encryption");
-           STORYT_VERIFY((bCryptMethod == 0x01)); // Only support Permute currently
+           STORYT_VERIFY((bCryptMethod != 0x10)); // Windows Information Protection is not supported
            STORYT_INFO("bCryptMethod [{}]", bCryptMethod);
             
            /*
@@ -274,12 +289,13 @@ namespace storyt
            */
            std::vector<types::byte_t> rgbReserved3 = utils::slice(bytes, 532, 564, 32);
 
-           return core::Header(core::Root::Init(root));
+           return core::Header(core::Root::Init(root), static_cast<types::CryptMethod>(bCryptMethod));
         }
 
     private:
-        std::ifstream m_file;
+        std::unique_ptr<io::BlockSource> m_source{nullptr};
         std::string m_path;
+        core::ReadOptions m_options{};
         std::unique_ptr<ndb::NDB> m_ndb{nullptr};
         std::unique_ptr<ltp::LTP> m_ltp{nullptr};
         std::unique_ptr<Messaging> m_msg{nullptr};
@@ -0,0 +1,468 @@
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <array>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define STORYT_SIMD_X86_ 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#else
+    #define STORYT_SIMD_X86_ 0
+#endif
+
+// GCC and Clang only emit an intrinsic inside a function compiled for its instruction set.
+// MSVC emits any intrinsic anywhere, so the attribute is dropped there.
+#if defined(__GNUC__) || defined(__clang__)
+    #define STORYT_SIMD_TARGET_(isa) __attribute__((target(isa)))
+#else
+    #define STORYT_SIMD_TARGET_(isa)
+#endif
+
+#include "types.h"
+#include "utils.h"
+
+#ifndef STORYT_SIMD_H
+#define STORYT_SIMD_H
+
+namespace storyt::simd {
+
+    enum class ISA
+    {
+        Scalar,
+        AVX2,
+        AVX512VBMI,
+        /// Carry-less multiply together with SSE4.1
+        PCLMUL
+    };
+
+    /**
+     * @brief Whether the CPU and the OS can run isa. Checked once per instruction set.
+    */
+    bool isSupported(ISA isa)
+    {
+#if STORYT_SIMD_X86_
+    #if defined(_MSC_VER) && !defined(__clang__)
+        static const uint64_t xcr0 = []() -> uint64_t {
+            int info[4]{};
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            return osxsave ? _xgetbv(0) : 0;
+        }();
+        static const bool hasAVX2 = []() {
+            int info[4]{};
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        }();
+        static const bool hasAVX512VBMI = []() {
+            int info[4]{};
+            __cpuidex(info, 7, 0);
+            const bool f = (info[1] & (1 << 16)) != 0;
+            const bool bw = (info[1] & (1 << 30)) != 0;
+            const bool vbmi = (info[2] & (1 << 1)) != 0;
+            return f && bw && vbmi && (xcr0 & 0xE6) == 0xE6;
+        }();
+        static const bool hasPCLMUL = []() {
+            int info[4]{};
+            __cpuid(info, 1);
+            return (info[2] & (1 << 1)) != 0 && (info[2] & (1 << 19)) != 0;
+        }();
+    #else
+        static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+        static const bool hasAVX512VBMI = __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi");
+        static const bool hasPCLMUL = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    #endif
+        switch (isa)
+        {
+        case ISA::Scalar: return true;
+        case ISA::AVX2: return hasAVX2;
+        case ISA::AVX512VBMI: return hasAVX512VBMI;
+        case ISA::PCLMUL: return hasPCLMUL;
+        }
+        return false;
+#else
+        return isa == ISA::Scalar;
+#endif
+    }
+
+    /**
+     * @brief The widest instruction set this CPU supports for the table lookup kernels.
+    */
+    ISA bestISA()
+    {
+        static const ISA best = []() {
+            for (const ISA isa : { ISA::AVX512VBMI, ISA::AVX2 })
+            {
+                if (isSupported(isa))
+                {
+                    return isa;
+                }
+            }
+            return ISA::Scalar;
+        }();
+        return best;
+    }
+
+    /**
+     * @brief The instruction set ComputeCRC uses by default.
+    */
+    ISA crcISA()
+    {
+        static const ISA best = isSupported(ISA::PCLMUL) ? ISA::PCLMUL : ISA::Scalar;
+        return best;
+    }
+
+    namespace detail {
+        /// The 3 tables of mpbbCrypt: mpbbR, mpbbS and mpbbI.
+        enum class CryptTable
+        {
+            R = 0,
+            S = 1,
+            I = 2
+        };
+
+        const types::byte_t* cryptTable(CryptTable table)
+        {
+            return utils::ms::mpbbCrypt + 256 * static_cast<size_t>(table);
+        }
+
+        /**
+         * @brief The permute table split into 2 halves of 8 rows each, picked by the top bit of the index, with every row
+         *  XORed with the row above it. The AVX2 lookup XORs together rows 0 through the index's row, which
+         *  cancels back out to just the index's row.
+        */
+        std::array<types::byte_t, 256> toRowDeltas(const types::byte_t* table)
+        {
+            std::array<types::byte_t, 256> deltas{};
+            for (size_t i = 0; i < 256; ++i)
+            {
+                const bool isFirstRowOfHalf = (i % 128) < 16;
+                deltas[i] = isFirstRowOfHalf ? table[i] : static_cast<types::byte_t>(table[i] ^ table[i - 16]);
+            }
+            return deltas;
+        }
+
+        const std::array<types::byte_t, 256>& rowDeltas(CryptTable table)
+        {
+            static const std::array<std::array<types::byte_t, 256>, 3> deltas = {
+                toRowDeltas(cryptTable(CryptTable::R)),
+                toRowDeltas(cryptTable(CryptTable::S)),
+                toRowDeltas(cryptTable(CryptTable::I))
+            };
+            return deltas[static_cast<size_t>(table)];
+        }
+
+#if STORYT_SIMD_X86_
+        struct TableAVX2
+        {
+            __m256i lowRows[8];
+            __m256i highRows[8];
+        };
+
+        STORYT_SIMD_TARGET_("avx2")
+        TableAVX2 loadTableAVX2(CryptTable table)
+        {
+            const std::array<types::byte_t, 256>& deltas = rowDeltas(table);
+            TableAVX2 ret{};
+            for (int r = 0; r < 8; ++r)
+            {
+                // vpshufb shuffles each 128 bit lane on its own so both lanes get the same row.
+                ret.lowRows[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas.data() + 16 * r)));
+                ret.highRows[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas.data() + 128 + 16 * r)));
+            }
+            return ret;
+        }
+
+        /*
+        * pshufb only looks up 16 bytes, so every row of the table is looked up by the low nibble. Subtracting
+        * 16 with signed saturation walks an index down one row at a time and pshufb returns 0 once the top
+        * bit is set. So row r contributes for every index whose row is >= r in its half, and the XOR of those
+        * row deltas is the wanted byte. The second half is handled the same way after flipping the top bit.
+        */
+        STORYT_SIMD_TARGET_("avx2")
+        inline __m256i lookupAVX2(const TableAVX2& table, __m256i x)
+        {
+            const __m256i rowStep = _mm256_set1_epi8(16);
+            __m256i low = x;
+            __m256i high = _mm256_xor_si256(x, _mm256_set1_epi8(static_cast<char>(0x80)));
+            __m256i lowRes = _mm256_setzero_si256();
+            __m256i highRes = _mm256_setzero_si256();
+            for (int r = 0; r < 8; ++r)
+            {
+                lowRes = _mm256_xor_si256(lowRes, _mm256_shuffle_epi8(table.lowRows[r], low));
+                highRes = _mm256_xor_si256(highRes, _mm256_shuffle_epi8(table.highRows[r], high));
+                low = _mm256_subs_epi8(low, rowStep);
+                high = _mm256_subs_epi8(high, rowStep);
+            }
+            return _mm256_xor_si256(lowRes, highRes);
+        }
+
+        struct TableAVX512VBMI
+        {
+            __m512i quarters[4];
+        };
+
+        STORYT_SIMD_TARGET_("avx512f,avx512bw,avx512vbmi")
+        TableAVX512VBMI loadTableAVX512VBMI(CryptTable table)
+        {
+            const types::byte_t* bytes = cryptTable(table);
+            TableAVX512VBMI ret{};
+            for (int q = 0; q < 4; ++q)
+            {
+                ret.quarters[q] = _mm512_loadu_si512(bytes + 64 * q);
+            }
+            return ret;
+        }
+
+        STORYT_SIMD_TARGET_("avx512f,avx512bw,avx512vbmi")
+        inline __m512i lookupAVX512VBMI(const TableAVX512VBMI& table, __m512i x)
+        {
+            // vpermi2b looks up 7 bits of index in 128 bytes, so the table is 2 halves picked by the top bit.
+            const __m512i low = _mm512_permutex2var_epi8(table.quarters[0], x, table.quarters[1]);
+            const __m512i high = _mm512_permutex2var_epi8(table.quarters[2], x, table.quarters[3]);
+            return _mm512_mask_blend_epi8(_mm512_movepi8_mask(x), low, high);
+        }
+
+        /*
+        * Each kernel returns how many bytes it processed, always a multiple of its vector width.
+        */
+        STORYT_SIMD_TARGET_("avx2")
+        size_t permuteAVX2(types::byte_t* data, size_t size, CryptTable which)
+        {
+            const TableAVX2 table = loadTableAVX2(which);
+            size_t i{ 0 };
+            for (; i + 32 <= size; i += 32)
+            {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), lookupAVX2(table, x));
+            }
+            return i;
+        }
+
+        STORYT_SIMD_TARGET_("avx512f,avx512bw,avx512vbmi")
+        size_t permuteAVX512VBMI(types::byte_t* data, size_t size, CryptTable which)
+        {
+            const TableAVX512VBMI table = loadTableAVX512VBMI(which);
+            size_t i{ 0 };
+            for (; i + 64 <= size; i += 64)
+            {
+                const __m512i x = _mm512_loadu_si512(data + i);
+                _mm512_storeu_si512(data + i, lookupAVX512VBMI(table, x));
+            }
+            return i;
+        }
+
+        /*
+        * The cyclic key w goes up by 1 for every byte. Across one vector the low byte of w is its starting value
+        * plus the lane number, and the high byte goes up by 1 in the lanes past the point where the low byte wraps.
+        */
+        STORYT_SIMD_TARGET_("avx2")
+        size_t cyclicAVX2(types::byte_t* data, size_t size, uint16_t w)
+        {
+            const TableAVX2 r = loadTableAVX2(CryptTable::R);
+            const TableAVX2 s = loadTableAVX2(CryptTable::S);
+            const TableAVX2 inv = loadTableAVX2(CryptTable::I);
+            const __m256i lanes = _mm256_setr_epi8(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+            size_t i{ 0 };
+            for (; i + 32 <= size; i += 32, w = static_cast<uint16_t>(w + 32))
+            {
+                const uint8_t wLow = static_cast<uint8_t>(w);
+                const uint8_t wHigh = static_cast<uint8_t>(w >> 8);
+                const __m256i low = _mm256_add_epi8(_mm256_set1_epi8(static_cast<char>(wLow)), lanes);
+                __m256i high = _mm256_set1_epi8(static_cast<char>(wHigh));
+                if (wLow > 256 - 32)
+                {
+                    // The lanes at or past 256 - wLow carried into the high byte. Subtracting -1 adds the carry.
+                    const __m256i carry = _mm256_cmpgt_epi8(lanes, _mm256_set1_epi8(static_cast<char>(255 - wLow)));
+                    high = _mm256_sub_epi8(high, carry);
+                }
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                b = lookupAVX2(r, _mm256_add_epi8(b, low));
+                b = lookupAVX2(s, _mm256_add_epi8(b, high));
+                b = lookupAVX2(inv, _mm256_sub_epi8(b, high));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_sub_epi8(b, low));
+            }
+            return i;
+        }
+
+        STORYT_SIMD_TARGET_("avx512f,avx512bw,avx512vbmi")
+        size_t cyclicAVX512VBMI(types::byte_t* data, size_t size, uint16_t w)
+        {
+            const TableAVX512VBMI r = loadTableAVX512VBMI(CryptTable::R);
+            const TableAVX512VBMI s = loadTableAVX512VBMI(CryptTable::S);
+            const TableAVX512VBMI inv = loadTableAVX512VBMI(CryptTable::I);
+            alignas(64) uint8_t laneNumbers[64];
+            for (int lane = 0; lane < 64; ++lane)
+            {
+                laneNumbers[lane] = static_cast<uint8_t>(lane);
+            }
+            const __m512i lanes = _mm512_load_si512(laneNumbers);
+            const __m512i one = _mm512_set1_epi8(1);
+            size_t i{ 0 };
+            for (; i + 64 <= size; i += 64, w = static_cast<uint16_t>(w + 64))
+            {
+                const uint8_t wLow = static_cast<uint8_t>(w);
+                const uint8_t wHigh = static_cast<uint8_t>(w >> 8);
+                const __m512i low = _mm512_add_epi8(_mm512_set1_epi8(static_cast<char>(wLow)), lanes);
+                const __m512i highBase = _mm512_set1_epi8(static_cast<char>(wHigh));
+                const __mmask64 carry = _mm512_cmpgt_epu8_mask(lanes, _mm512_set1_epi8(static_cast<char>(255 - wLow)));
+                const __m512i high = _mm512_mask_add_epi8(highBase, carry, highBase, one);
+
+                __m512i b = _mm512_loadu_si512(data + i);
+                b = lookupAVX512VBMI(r, _mm512_add_epi8(b, low));
+                b = lookupAVX512VBMI(s, _mm512_add_epi8(b, high));
+                b = lookupAVX512VBMI(inv, _mm512_sub_epi8(b, high));
+                _mm512_storeu_si512(data + i, _mm512_sub_epi8(b, low));
+            }
+            return i;
+        }
+
+        /*
+        * CRC-32 by folding with carry-less multiplies, as laid out in Intel's "Fast CRC Computation for
+        * Generic Polynomials Using PCLMULQDQ Instruction" and used by zlib and the Linux kernel.
+        * 4 lanes of 128 bits are folded 64 bytes at a time, folded down into 1 lane, folded 16 bytes at
+        * a time, and then Barrett reduced to 32 bits. The constants are for the bit reflected IEEE polynomial
+        * 0xEDB88320 that CrcTableOffset32 is built from. crc is the raw running value, so there is no
+        * inversion before or after, which is what utils::ms::ComputeCRC expects too.
+        * size must be at least 64 and a multiple of 16.
+        */
+        STORYT_SIMD_TARGET_("pclmul,sse4.1")
+        inline __m128i foldPCLMUL(__m128i x, __m128i k, __m128i next)
+        {
+            const __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+            const __m128i high = _mm_clmulepi64_si128(x, k, 0x11);
+            return _mm_xor_si128(_mm_xor_si128(high, low), next);
+        }
+
+        STORYT_SIMD_TARGET_("pclmul,sse4.1")
+        uint32_t crcPCLMUL(uint32_t crc, const types::byte_t* data, size_t size)
+        {
+            alignas(16) static constexpr uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+            alignas(16) static constexpr uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+            alignas(16) static constexpr uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+            alignas(16) static constexpr uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+            auto load = [](const types::byte_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+            __m128i x1 = _mm_xor_si128(load(data), _mm_cvtsi32_si128(static_cast<int>(crc)));
+            __m128i x2 = load(data + 16);
+            __m128i x3 = load(data + 32);
+            __m128i x4 = load(data + 48);
+            data += 64;
+            size -= 64;
+
+            __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+            for (; size >= 64; data += 64, size -= 64)
+            {
+                x1 = foldPCLMUL(x1, k, load(data));
+                x2 = foldPCLMUL(x2, k, load(data + 16));
+                x3 = foldPCLMUL(x3, k, load(data + 32));
+                x4 = foldPCLMUL(x4, k, load(data + 48));
+            }
+
+            k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+            x1 = foldPCLMUL(x1, k, x2);
+            x1 = foldPCLMUL(x1, k, x3);
+            x1 = foldPCLMUL(x1, k, x4);
+            for (; size >= 16; data += 16, size -= 16)
+            {
+                x1 = foldPCLMUL(x1, k, load(data));
+            }
+
+            // 128 bits down to 64
+            const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+            __m128i x0 = _mm_clmulepi64_si128(x1, k, 0x10);
+            x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x0);
+            k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+            x0 = _mm_srli_si128(x1, 4);
+            x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00), x0);
+
+            // Barrett reduction down to 32 bits
+            k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+            x0 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+            x0 = _mm_clmulepi64_si128(_mm_and_si128(x0, mask32), k, 0x00);
+            x1 = _mm_xor_si128(x1, x0);
+            return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+        }
+#endif
+    } // namespace detail
+
+    /**
+     * @brief NDB_CRYPT_PERMUTE over data in place. Produces exactly the bytes utils::ms::CryptPermute does,
+     *  which still decodes whatever is left over after the last full vector.
+     * @param isa = the instruction set to use. Defaults to the widest one the CPU supports.
+    */
+    void CryptPermute(std::span<types::byte_t> data, bool encrypt, ISA isa = bestISA())
+    {
+        STORYT_ASSERT(isSupported(isa), "Instruction set [{}] is not supported by this CPU", static_cast<int>(isa));
+        size_t nDone{ 0 };
+#if STORYT_SIMD_X86_
+        // mpbbR is the encode table and mpbbI the decode table.
+        const detail::CryptTable table = encrypt ? detail::CryptTable::R : detail::CryptTable::I;
+        switch (isa)
+        {
+        case ISA::AVX2: nDone = detail::permuteAVX2(data.data(), data.size(), table); break;
+        case ISA::AVX512VBMI: nDone = detail::permuteAVX512VBMI(data.data(), data.size(), table); break;
+        default: break;
+        }
+#endif
+        utils::ms::CryptPermute(
+            data.data() + nDone,
+            static_cast<int>(data.size() - nDone),
+            encrypt ? utils::ms::ENCODE_DATA : utils::ms::DECODE_DATA
+        );
+    }
+
+    /**
+     * @brief NDB_CRYPT_CYCLIC over data in place. Encoding and decoding are the same operation. Produces exactly
+     *  the bytes utils::ms::CryptCyclic does, which still handles whatever is left over after the last full vector.
+     * @param key = the lower DWORD of the BID of the data block.
+    */
+    void CryptCyclic(std::span<types::byte_t> data, uint32_t key, ISA isa = bestISA())
+    {
+        STORYT_ASSERT(isSupported(isa), "Instruction set [{}] is not supported by this CPU", static_cast<int>(isa));
+        const uint16_t w = static_cast<uint16_t>(key ^ (key >> 16));
+        size_t nDone{ 0 };
+#if STORYT_SIMD_X86_
+        switch (isa)
+        {
+        case ISA::AVX2: nDone = detail::cyclicAVX2(data.data(), data.size(), w); break;
+        case ISA::AVX512VBMI: nDone = detail::cyclicAVX512VBMI(data.data(), data.size(), w); break;
+        default: break;
+        }
+#endif
+        // A key with its upper 16 bits clear folds down to itself, so the byte loop picks up where the vectors stopped.
+        utils::ms::CryptCyclic(
+            data.data() + nDone,
+            static_cast<int>(data.size() - nDone),
+            static_cast<uint16_t>(w + nDone)
+        );
+    }
+
+    /**
+     * @brief The CRC the BLOCKTRAILER and PAGETRAILER of a PST hold. Produces exactly what utils::ms::ComputeCRC does,
+     *  which is still used for blocks shorter than 64 bytes and for the bytes after the last 16 byte chunk.
+     * @param crc = the CRC of the bytes before data, 0 to start a new CRC.
+    */
+    uint32_t ComputeCRC(uint32_t crc, std::span<const types::byte_t> data, ISA isa = crcISA())
+    {
+        STORYT_ASSERT(isSupported(isa), "Instruction set [{}] is not supported by this CPU", static_cast<int>(isa));
+        size_t nDone{ 0 };
+#if STORYT_SIMD_X86_
+        if (isa == ISA::PCLMUL && data.size() >= 64)
+        {
+            nDone = data.size() & ~size_t{ 15 };
+            crc = detail::crcPCLMUL(crc, data.data(), nDone);
+        }
+#endif
+        return utils::ms::ComputeCRC(crc, data.data() + nDone, static_cast<uint32_t>(data.size() - nDone));
+    }
+
+} // namespace storyt::simd
+
+#endif // !STORYT_SIMD_H
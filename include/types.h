@@ -62,6 +62,14 @@ namespace storyt::types {
         Invalid
     };
 
+    enum class CryptMethod : uint8_t
+    {
+        NONE = 0x00,        // NDB_CRYPT_NONE          Data blocks are not encoded
+        PERMUTE = 0x01,     // NDB_CRYPT_PERMUTE       Encoded with the Permutation algorithm
+        CYCLIC = 0x02,      // NDB_CRYPT_CYCLIC        Encoded with the Cyclic algorithm
+        EDPCRYPTED = 0x10   // NDB_CRYPT_EDPCRYPTED    Encrypted with Windows Information Protection
+    };
+
     enum class BlockType : uint32_t
     {
         DATA = 0xFF,
@@ -245,6 +253,10 @@ namespace storyt::types {
         static constexpr Info RecipEmailAddress = Info{ 0x3003, PropertyType::String };
         /// PTString
         static constexpr Info SenderEmailAddress = Info{ 0x0C1F, PropertyType::String };
+        /// Time - FILETIME the message was delivered
+        static constexpr Info MessageDeliveryTime = Info{ 0x0E06, PropertyType::Time };
+        /// Integer32 - Size of the message in bytes
+        static constexpr Info MessageSize = Info{ 0x0E08, PropertyType::Integer32 };
     };
 } // namespace::reader::types
 
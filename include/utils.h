@@ -7,6 +7,10 @@
 #include <array>
 #include <stdexcept>
 #include <span>
+#include <cstring>
+#include <bit>
+#include <type_traits>
+#include <algorithm>
 
 // NOLINTBEGIN
 
@@ -628,14 +632,53 @@ namespace storyt::utils {
         return result;
     }
 
+    /**
+     * @brief Reads a little endian T from bytes without allocating. When bytes is shorter than T
+     *  the missing high bytes are zero, which is what a field narrower than its type needs.
+     *  When bytes is longer than T only its first sizeof(T) bytes are read.
+     * @param bytes = the bytes of the field. Does NOT need to be aligned.
+    */
+    template<typename T>
+    T loadLE(std::span<const types::byte_t> bytes)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+        // Sizes come from the file so they are clamped even in release builds instead of overrunning value.
+        const size_t nBytes = std::min(bytes.size(), sizeof(T));
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            T value{};
+            // memcpy is the only well defined unaligned load. A constant size lets it become a single mov.
+            if (nBytes == sizeof(T))
+            {
+                std::memcpy(&value, bytes.data(), sizeof(T));
+            }
+            else
+            {
+                std::memcpy(&value, bytes.data(), nBytes);
+            }
+            return value;
+        }
+        else
+        {
+            static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "T must be integral on a big endian host");
+            using Unsigned_t = std::make_unsigned_t<std::conditional_t<std::is_enum_v<T>, std::underlying_type_t<T>, T>>;
+            Unsigned_t value{ 0 };
+            for (size_t i = nBytes; i > 0; --i)
+            {
+                value = static_cast<Unsigned_t>((value << 8) | bytes[i - 1]);
+            }
+            return static_cast<T>(value);
+        }
+    }
+
     template<typename T, typename Container = std::vector<types::byte_t>>
     T toT_l(const Container& b)
     {
-        auto bytes = b; //pad(b, sizeof(T) - b.size());
         if constexpr (std::is_same_v<Container, std::vector<types::byte_t>>)
         {
-            bytes = pad(b, sizeof(T) - b.size());
+            return loadLE<T>(b);
         }
+        const Container& bytes = b;
         STORYT_ASSERT((sizeof(T) == bytes.size()), "Size of T [{}] != [{}] bytes.size()", sizeof(T), bytes.size());
         if constexpr (sizeof(T) == 1)
         {
@@ -753,9 +796,9 @@ namespace storyt::utils {
     class ByteView
     {
     public:
-        ByteView(const std::vector<types::byte_t>& bytes)
+        ByteView(std::span<const types::byte_t> bytes)
             : m_bytes(bytes) {}
-        ByteView(const std::vector<types::byte_t>& bytes, size_t start)
+        ByteView(std::span<const types::byte_t> bytes, size_t start)
             : m_bytes(bytes), m_start(start) 
         {
             STORYT_ASSERT((start < bytes.size()), "Start [{}] must <= bytes.size() [{}]", start, bytes.size());
@@ -782,18 +825,27 @@ namespace storyt::utils {
 
         std::vector<types::byte_t> read(size_t size)
         {
+            const std::span<const types::byte_t> bytes = readView(size);
+            return std::vector<types::byte_t>(bytes.begin(), bytes.end());
+        }
+
+        /**
+         * @brief Same as read(size) but the returned bytes are NOT copied. They are
+         *  only valid for as long as the bytes this ByteView was created from.
+         * @throws std::out_of_range when fewer than size bytes are left. Every read and entry goes through here.
+        */
+        std::span<const types::byte_t> readView(size_t size)
+        {
+            _checkInBounds(size);
             const size_t start = m_start;
             m_start += size;
-            return slice(m_bytes, start, start + size, size);
+            return m_bytes.subspan(start, size);
         }
 
         template<typename PrimitiveType>
         PrimitiveType read(size_t size)
         {
-            //STORYT_ASSERT((sizeof(PrimitiveType) == size), "PrimitiveType Size [{}] != Size [{}]", sizeof(PrimitiveType), size);
-            const size_t start = m_start;
-            m_start += size;
-            return slice(m_bytes, start, start + size, size, toT_l<PrimitiveType>);
+            return loadLE<PrimitiveType>(readView(size));
         }
 
         template<typename PrimitiveType>
@@ -812,12 +864,13 @@ namespace storyt::utils {
             return res;
         }
 
+        /**
+         * @brief EntryType is constructed from a view of the next size bytes. Nothing is copied unless EntryType keeps the bytes.
+        */
         template<typename EntryType, typename ...Args>
         EntryType entry(size_t size, Args&& ... args)
         {
-            const size_t start = m_start;
-            m_start += size;
-            return EntryType(slice(m_bytes, start, start + size, size), std::forward<Args>(args)...);
+            return EntryType(readView(size), std::forward<Args>(args)...);
         }
 
         template<typename EntryType, typename ...Args>
@@ -838,7 +891,7 @@ namespace storyt::utils {
         template<typename RetType = std::vector<types::byte_t>>
         RetType takeLast(size_t nBytes)
         {
-            STORYT_ASSERT((nBytes <= (m_bytes.size() - m_start)), "takeLast");
+            _checkInBounds(nBytes);
             const size_t offset = m_bytes.size() - m_start - nBytes;
             skip(offset);
             if constexpr (std::is_same_v<RetType, std::vector<types::byte_t>>)
@@ -864,7 +917,21 @@ namespace storyt::utils {
         }
 
     private:
-        const std::vector<types::byte_t>& m_bytes;
+        /**
+         * @brief Throws std::out_of_range when the next size bytes are not all inside the ByteView.
+         *  The bytes often come straight from the file so a corrupt size must not turn into a read past the end.
+        */
+        void _checkInBounds(size_t size) const
+        {
+            if (m_start > m_bytes.size() || size > m_bytes.size() - m_start)
+            {
+                throw std::out_of_range("Read [" + std::to_string(size) + "] bytes at [" + std::to_string(m_start) + 
+                    "] past the end of the ByteView [" + std::to_string(m_bytes.size()) + "]");
+            }
+        }
+
+    private:
+        std::span<const types::byte_t> m_bytes;
         size_t m_start{ 0 };
     };
 
@@ -910,13 +977,11 @@ namespace storyt::utils {
     {
     public:
         Array() = default;
-        explicit Array(const std::vector<types::byte_t>& data)
+        explicit Array(std::span<const types::byte_t> data)
         {
             static_assert(std::is_same_v<DataType, types::byte_t>);
-            for (size_t i = 0; i < data.size(); ++i)
-            {
-                m_data[i] = data.at(i);
-            }
+            STORYT_ASSERT((data.size() <= Size), "Array of [{}] can NOT hold [{}] bytes", Size, data.size());
+            std::copy(data.begin(), data.end(), m_data.begin());
         }
 
         ArrayView<DataType, Size> view(size_t start, size_t end) const
@@ -927,7 +992,7 @@ namespace storyt::utils {
         std::array<DataType, Size> m_data{};
     };
 
-    std::string UTF16BytesToString(const std::vector<types::byte_t>& bytes)
+    std::string UTF16BytesToString(std::span<const types::byte_t> bytes)
     {
         ByteView view(bytes);
         std::vector<uint8_t> characters = view.read<uint8_t>(bytes.size() / 2U, 1U, 1U);
@@ -959,7 +1024,7 @@ namespace storyt::utils {
         typedef unsigned char byte;
         typedef const void* LPCVOID;
         typedef void VOID, * PVOID, * LPVOID;
-        typedef unsigned long DWORD, * PDWORD, * LPDWORD;
+        typedef uint32_t DWORD, * PDWORD, * LPDWORD; // unsigned long is 8 bytes on LP64 platforms
         typedef unsigned short WORD, * PWORD, * LPWORD;
         typedef int BOOL, * PBOOL, * LPBOOL;
         typedef unsigned long long ULONG_PTR;
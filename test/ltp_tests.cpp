@@ -3,6 +3,7 @@
 #include <stdarg.h>
 #include <cassert>
 #include <vector>
+#include <filesystem>
 
 #include <gtest/gtest.h>
 
@@ -52,4 +53,198 @@ namespace ltp_tests
 		ASSERT_EQ(hnhdr.ibHnpm, 0x00EC);
 	}
 
+	/// Writes heap to path as the only data block of a DataTree followed by its padding and block trailer.
+	void writeHNBlock(const std::filesystem::path& path, uint64_t bid, const std::vector<byte_t>& heap = sample_HN)
+	{
+		const auto [blockSize, padding] = DataTree::calcBlockAlignedSize(heap.size());
+		std::vector<byte_t> block(heap);
+		block.resize(blockSize, 0);
+		const uint32_t crc = ms::ComputeCRC(0, heap.data(), static_cast<uint32_t>(heap.size()));
+		const size_t trailer = blockSize - 16;
+		for (const auto& [offset, value, size] : std::vector<std::tuple<size_t, uint64_t, size_t>>{
+			{ trailer, heap.size(), 2 }, { trailer + 2, ms::ComputeSig(0, bid), 2 }, { trailer + 4, crc, 4 }, { trailer + 8, bid, 8 } })
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				block[offset + i] = static_cast<byte_t>(value >> (8 * i));
+			}
+		}
+		std::ofstream out(path, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(block.data()), block.size());
+	}
+
+	TEST(HNTests, AllocationsAndRecordsViewTheDataTree)
+	{
+		const uint64_t bid = 0x4;
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_hn_views_test.bin";
+		writeHNBlock(path, bid);
+		{
+			const std::unique_ptr<storyt::io::BlockSource> source = storyt::io::BlockSource::Init(path.string(), storyt::io::SourceType::PositionalRead);
+			const DataTree::GetBBT_t getBBT = [](const BID&) -> std::optional<BBTEntry> { return std::nullopt; };
+			const HN hn = HN::Init(NID(0x21), DataTree(Ref<const storyt::io::BlockSource>(*source), getBBT, BREF(bid, 0), sample_HN.size(), CryptMethod::NONE));
+
+			const std::span<const byte_t> blockData = hn.at(0).data;
+			const std::span<const byte_t> header = hn.getAllocation(hn.getHeader().hidUserRoot);
+			ASSERT_EQ(header.size(), 8);
+			ASSERT_EQ(header.data(), blockData.data() + 0x0C);
+
+			const BTreeHeap bth(hn, hn.getHeader().hidUserRoot);
+			ASSERT_EQ(bth.nLeafRecordsHint(hn), 11);
+			ASSERT_EQ(bth.nrecords(hn), 11);
+			const PCBTHRecord first = bth.records(hn).front().as<PCBTHRecord>();
+			ASSERT_EQ(first.wPropId, 0x0E34);
+			ASSERT_EQ(first.wPropType, 0x0102);
+
+			// find gives the same record as the full scan and misses on keys between and around the records.
+			const std::vector<Record>& records = bth.records(hn);
+			for (size_t i = 0; i < records.size(); ++i)
+			{
+				const PCBTHRecord expected = records[i].as<PCBTHRecord>();
+				const std::optional<Record> found = bth.find(hn, expected.wPropId);
+				ASSERT_TRUE(found.has_value());
+				ASSERT_EQ(found->as<PCBTHRecord>().wPropId, expected.wPropId);
+				ASSERT_EQ(found->as<PCBTHRecord>().dwValueHnid, expected.dwValueHnid);
+				const bool nextIsAdjacent = i + 1 < records.size() && records[i + 1].as<PCBTHRecord>().wPropId == expected.wPropId + 1U;
+				ASSERT_EQ(bth.find(hn, expected.wPropId + 1U).has_value(), nextIsAdjacent);
+			}
+			ASSERT_FALSE(bth.find(hn, 0x0001).has_value());
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(HNTests, FindScansBTHsWithKeysWiderThan8Bytes)
+	{
+		// HNHDR, a BTHHEADER with 16 byte keys and 4 byte data at HID 0x20, its 3 leaf records at HID 0x40 and the HNPAGEMAP.
+		std::vector<byte_t> heap{ 0x50, 0x00, 0xEC, 0xB5, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+		heap.insert(heap.end(), { 0xB5, 16, 4, 0, 0x40, 0x00, 0x00, 0x00 });
+		for (const auto& [low, high, data] : std::vector<std::tuple<uint64_t, uint64_t, byte_t>>{ { 5, 0, 0xAA }, { 9, 0, 0xBB }, { 7, 1, 0xCC } })
+		{
+			for (const uint64_t half : { low, high })
+			{
+				for (size_t b = 0; b < 8; ++b)
+				{
+					heap.push_back(static_cast<byte_t>(half >> (8 * b)));
+				}
+			}
+			heap.insert(heap.end(), 4, data);
+		}
+		heap.insert(heap.end(), { 0x02, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x14, 0x00, 0x50, 0x00 });
+
+		const uint64_t bid = 0x4;
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_bth_wide_keys_test.bin";
+		writeHNBlock(path, bid, heap);
+		{
+			const std::unique_ptr<storyt::io::BlockSource> source = storyt::io::BlockSource::Init(path.string(), storyt::io::SourceType::PositionalRead);
+			const DataTree::GetBBT_t getBBT = [](const BID&) -> std::optional<BBTEntry> { return std::nullopt; };
+			const HN hn = HN::Init(NID(0x21), DataTree(Ref<const storyt::io::BlockSource>(*source), getBBT, BREF(bid, 0), heap.size(), CryptMethod::NONE));
+			const BTreeHeap bth(hn, hn.getHeader().hidUserRoot);
+			ASSERT_EQ(bth.getKeySize(), 16);
+			ASSERT_EQ(bth.nrecords(hn), 3);
+
+			const std::optional<Record> found = bth.find(hn, 9);
+			ASSERT_TRUE(found.has_value());
+			ASSERT_EQ(found->key().size(), 16);
+			ASSERT_EQ(found->as<LeafBTHRecord>().data, std::vector<byte_t>(4, 0xBB));
+			ASSERT_EQ(bth.find(hn, 5)->as<LeafBTHRecord>().data, std::vector<byte_t>(4, 0xAA));
+			// The key of the last record only matches 7 in its low 8 bytes
+			ASSERT_FALSE(bth.find(hn, 7).has_value());
+			ASSERT_FALSE(bth.find(hn, 6).has_value());
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(HNTests, FindDescendsThroughIntermediateLevels)
+	{
+		// HNHDR, a BTHHEADER with 2 byte keys, 6 byte data and 1 index level at HID 0x20, the root intermediate records
+		// at HID 0x40 and their two leaves at HID 0x60 (keys 0x10, 0x20, 0x30) and HID 0x80 (keys 0x40, 0x50).
+		std::vector<byte_t> heap{ 0x48, 0x00, 0xEC, 0xB5, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+		heap.insert(heap.end(), { 0xB5, 2, 6, 1, 0x40, 0x00, 0x00, 0x00 });
+		heap.insert(heap.end(), { 0x10, 0x00, 0x60, 0x00, 0x00, 0x00, 0x40, 0x00, 0x80, 0x00, 0x00, 0x00 });
+		for (const byte_t key : { 0x10, 0x20, 0x30, 0x40, 0x50 })
+		{
+			heap.insert(heap.end(), { key, 0x00 });
+			heap.insert(heap.end(), 6, key);
+		}
+		heap.insert(heap.end(), { 0x04, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x14, 0x00, 0x20, 0x00, 0x38, 0x00, 0x48, 0x00 });
+
+		const uint64_t bid = 0x4;
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_bth_two_levels_test.bin";
+		writeHNBlock(path, bid, heap);
+		{
+			const std::unique_ptr<storyt::io::BlockSource> source = storyt::io::BlockSource::Init(path.string(), storyt::io::SourceType::PositionalRead);
+			const DataTree::GetBBT_t getBBT = [](const BID&) -> std::optional<BBTEntry> { return std::nullopt; };
+			const HN hn = HN::Init(NID(0x21), DataTree(Ref<const storyt::io::BlockSource>(*source), getBBT, BREF(bid, 0), heap.size(), CryptMethod::NONE));
+			const BTreeHeap bth(hn, hn.getHeader().hidUserRoot);
+
+			// The first and last key of each leaf
+			for (const byte_t key : { 0x10, 0x20, 0x30, 0x40, 0x50 })
+			{
+				const std::optional<Record> found = bth.find(hn, key);
+				ASSERT_TRUE(found.has_value());
+				ASSERT_EQ(found->as<LeafBTHRecord>().data, std::vector<byte_t>(6, key));
+			}
+			// Below the first key, inside a leaf, between the two leaves and past the last key
+			for (const uint64_t key : { 0x0, 0xF, 0x25, 0x38, 0x3F, 0x45, 0x51, 0xFFFF })
+			{
+				ASSERT_FALSE(bth.find(hn, key).has_value());
+			}
+			// Only known after reading the leaves
+			ASSERT_EQ(bth.nLeafRecordsHint(hn), 0);
+			ASSERT_EQ(bth.nrecords(hn), 5);
+			ASSERT_EQ(bth.records(hn).back().as<LeafBTHRecord>().data, std::vector<byte_t>(6, 0x50));
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(PropertyContextTests, FindsPropertiesOnFirstUse)
+	{
+		const uint64_t bid = 0x4;
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_pc_table_test.bin";
+		writeHNBlock(path, bid);
+		{
+			const std::unique_ptr<storyt::io::BlockSource> source = storyt::io::BlockSource::Init(path.string(), storyt::io::SourceType::PositionalRead);
+			const DataTree::GetBBT_t getBBT = [](const BID&) -> std::optional<BBTEntry> { return std::nullopt; };
+			DataTree datatree(Ref<const storyt::io::BlockSource>(*source), getBBT, BREF(bid, 0), sample_HN.size(), CryptMethod::NONE);
+			PropertyContext pc = PropertyContext::Init(NID(0x21), &datatree, nullptr);
+
+			// Stored in the HNID
+			Property* flag = pc.TryToGetProperty(0x0E38, PropertyType::Integer32);
+			ASSERT_NE(flag, nullptr);
+			ASSERT_EQ(flag->asPTInt32(), 0);
+
+			// Stored in the heap and larger than a Property holds inline
+			Property* str = pc.TryToGetProperty(0x3001, PropertyType::String);
+			ASSERT_NE(str, nullptr);
+			ASSERT_GT(str->data().size(), Property::InlineSize);
+			ASSERT_EQ(str->asPTString().data, "UNICODE1");
+
+			// Properties do not move once handed out, even as others are added to the table around them
+			for (const auto& [pid, type] : std::vector<std::pair<uint32_t, storyt::types::PropertyType>>{
+				{ 0x0E34, PropertyType::Binary }, { 0x0FF9, PropertyType::Binary }, { 0x35DF, PropertyType::Integer32 },
+				{ 0x35E0, PropertyType::Binary }, { 0x6633, PropertyType::Boolean }, { 0x67FF, PropertyType::Integer32 } })
+			{
+				ASSERT_TRUE(pc.HasPropertyWPidAndPtypeOf(pid, type));
+				ASSERT_NE(pc.TryToGetProperty(pid, type), nullptr);
+			}
+			ASSERT_EQ(pc.TryToGetProperty(0x0E38, PropertyType::Integer32), flag);
+			ASSERT_EQ(pc.TryToGetProperty(0x3001, PropertyType::String), str);
+
+			ASSERT_EQ(pc.TryToGetProperty(0x3001, PropertyType::Integer32), nullptr);
+			ASSERT_EQ(pc.TryToGetProperty(0x0001, PropertyType::Integer32), nullptr);
+			ASSERT_EQ(pc.TryToGetProperty(0xFFFF, PropertyType::Integer32), nullptr);
+			// Misses are not stored so probing for absent PIDs leaves the properties already found where they are
+			for (uint32_t pid = 0x0001; pid < 0x0100; ++pid)
+			{
+				ASSERT_EQ(pc.TryToGetProperty(pid, PropertyType::Integer32), nullptr);
+			}
+			ASSERT_EQ(pc.TryToGetProperty(0x0E38, PropertyType::Integer32), flag);
+			ASSERT_TRUE(pc.HasPropertyWPidOf(0x0E34));
+			ASSERT_TRUE(pc.HasPropertyWPidOf(0x67FF));
+			ASSERT_FALSE(pc.HasPropertyWPidOf(0x35E1));
+			ASSERT_TRUE(pc.HasPropertyWPidAndPtypeOf(0x35DF, PropertyType::Integer32));
+			ASSERT_FALSE(pc.HasPropertyWPidAndPtypeOf(0x35DF, PropertyType::Binary));
+		}
+		std::filesystem::remove(path);
+	}
+
 }; // end namespace ltp_tests
\ No newline at end of file
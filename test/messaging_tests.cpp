@@ -0,0 +1,253 @@
+#include <iostream>
+#include <fstream>
+#include <stdarg.h>
+#include <cassert>
+#include <vector>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "types.h"
+#include "utils.h"
+#include "core.h"
+#include "io.h"
+#include "ndb.h"
+#include "ltp.h"
+#include "messaging.h"
+
+namespace messaging_tests
+{
+	using namespace storyt;
+	using namespace storyt::types;
+	using namespace storyt::core;
+	using namespace storyt::io;
+	using namespace storyt::ndb;
+
+	/// Counts the reads that reach the file so a test can tell which blocks were read.
+	class CountingSource : public BlockSource
+	{
+	public:
+		explicit CountingSource(std::unique_ptr<BlockSource> source)
+			: m_source(std::move(source)) {}
+
+		[[nodiscard]] Bytes read(uint64_t position, size_t nBytes) const override
+		{
+			m_reads.emplace_back(position, nBytes);
+			return m_source->read(position, nBytes);
+		}
+		[[nodiscard]] uint64_t size() const override { return m_source->size(); }
+		[[nodiscard]] SourceType type() const override { return m_source->type(); }
+
+		/// The number of reads that covered the file offset ib
+		[[nodiscard]] size_t nReadsOf(uint64_t ib) const
+		{
+			return static_cast<size_t>(std::ranges::count_if(m_reads, [ib](const auto& read) {
+				return read.first <= ib && ib < read.first + read.second;
+			}));
+		}
+		void reset()
+		{
+			m_reads.clear();
+		}
+
+	private:
+		std::unique_ptr<BlockSource> m_source;
+		mutable std::vector<std::pair<uint64_t, size_t>> m_reads{};
+	};
+
+	struct PCProperty
+	{
+		uint16_t pid{};
+		PropertyType type{};
+		std::vector<byte_t> value{};
+		/// When not 0 the value is stored in the subnode with this NID instead
+		uint32_t subnode{ 0 };
+	};
+
+	std::vector<byte_t> UTF16(const std::string& str)
+	{
+		std::vector<byte_t> bytes{};
+		for (const char c : str)
+		{
+			bytes.push_back(static_cast<byte_t>(c));
+			bytes.push_back(0x00);
+		}
+		return bytes;
+	}
+
+	std::vector<byte_t> LE(uint64_t value, size_t size)
+	{
+		std::vector<byte_t> bytes{};
+		ndb_tests::NDBFile::append(bytes, value, size);
+		return bytes;
+	}
+
+	/**
+	 * @brief A PC heap with a property for each of props, which are sorted by PID. Values that fit are
+	 *  stored in the HNID and every other value that is not in a subnode gets an allocation of its own.
+	*/
+	std::vector<byte_t> makePCHeap(const std::vector<PCProperty>& props)
+	{
+		std::vector<byte_t> heap(12, 0); // HNHDR
+		std::vector<uint16_t> rgibAlloc{ static_cast<uint16_t>(heap.size()) };
+		const std::vector<byte_t> bthHeader{ 0xB5, 2, 6, 0, 0x40, 0x00, 0x00, 0x00 };
+		heap.insert(heap.end(), bthHeader.begin(), bthHeader.end());
+		rgibAlloc.push_back(static_cast<uint16_t>(heap.size()));
+
+		std::vector<std::vector<byte_t>> values{};
+		for (const PCProperty& prop : props)
+		{
+			const storyt::utils::PTInfo info = storyt::utils::PropertyTypeInfo(static_cast<uint16_t>(prop.type));
+			uint32_t hnid = prop.subnode;
+			if (hnid == 0 && info.isFixed && info.singleEntrySize <= 4)
+			{
+				hnid = storyt::utils::loadLE<uint32_t>(prop.value);
+			}
+			else if (hnid == 0)
+			{
+				values.push_back(prop.value);
+				hnid = static_cast<uint32_t>(values.size() + 2) << 5U; // Allocations 1 and 2 are the BTH
+			}
+			ndb_tests::NDBFile::append(heap, prop.pid, 2);
+			ndb_tests::NDBFile::append(heap, static_cast<uint16_t>(prop.type), 2);
+			ndb_tests::NDBFile::append(heap, hnid, 4);
+		}
+		for (const std::vector<byte_t>& value : values)
+		{
+			rgibAlloc.push_back(static_cast<uint16_t>(heap.size()));
+			heap.insert(heap.end(), value.begin(), value.end());
+		}
+		rgibAlloc.push_back(static_cast<uint16_t>(heap.size()));
+		if (heap.size() % 2 != 0) // The HNPAGEMAP is 2 byte aligned
+		{
+			heap.push_back(0);
+		}
+
+		const uint16_t ibHnpm = static_cast<uint16_t>(heap.size());
+		ndb_tests::NDBFile::append(heap, rgibAlloc.size() - 1, 2); // cAlloc
+		ndb_tests::NDBFile::append(heap, 0, 2); // cFree
+		for (const uint16_t ib : rgibAlloc)
+		{
+			ndb_tests::NDBFile::append(heap, ib, 2);
+		}
+		const std::vector<byte_t> hnhdr{ static_cast<byte_t>(ibHnpm), static_cast<byte_t>(ibHnpm >> 8U), 0xEC, 0xBC, 0x20, 0x00, 0x00, 0x00 };
+		std::ranges::copy(hnhdr, heap.begin());
+		return heap;
+	}
+
+	/**
+	 * A message, NID 0x200024 in the NDBFile, whose body is in its subnode tree next to a recipient
+	 *  table and an attachment table. Neither table is valid so they must never be read.
+	*/
+	struct MessageFile
+	{
+		static constexpr uint32_t messageNID = 0x200024;
+		static constexpr uint32_t bodyNID = 0x8001;
+		static constexpr uint64_t pcBID = 0x100;
+		static constexpr uint64_t subBID = 0x102;
+		static constexpr uint64_t recipBID = 0x104;
+		static constexpr uint64_t attachBID = 0x108;
+		static constexpr uint64_t bodyBID = 0x10C;
+		static constexpr uint64_t deliveryTime = 0x01DA2B3C4D5E6F70ULL;
+		static constexpr int32_t messageSize = 4321;
+		inline static const std::string body = "Hello from the body";
+
+		ndb_tests::NDBFile file;
+		CountingSource source;
+
+		explicit MessageFile(const std::string& name)
+			:
+			file(name, { { messageNID, { pcBID, subBID } } }, {
+				{ pcBID, makePCHeap({
+					{ 0x001A, PropertyType::String, UTF16("IPM.Note") },
+					{ 0x0037, PropertyType::String, UTF16("Subject") },
+					{ 0x0E06, PropertyType::Time, LE(deliveryTime, 8) },
+					{ 0x0E07, PropertyType::Integer32, LE(0x1, 4) },
+					{ 0x0E08, PropertyType::Integer32, LE(messageSize, 4) },
+					{ 0x1000, PropertyType::String, {}, bodyNID },
+					{ 0x3007, PropertyType::Time, LE(deliveryTime - 1, 8) },
+					{ 0x3008, PropertyType::Time, LE(deliveryTime + 1, 8) },
+					{ 0x300B, PropertyType::Binary, std::vector<byte_t>(16, 0x5A) } }) },
+				{ subBID, ndb_tests::makeSLBlockData({ { 0x671, attachBID, 0x0 }, { 0x692, recipBID, 0x0 }, { bodyNID, bodyBID, 0x0 } }) },
+				{ recipBID, std::vector<byte_t>(40, 0xEE) },
+				{ attachBID, std::vector<byte_t>(40, 0xEE) },
+				{ bodyBID, UTF16(body) } }),
+			source(BlockSource::Init(file.path.string(), SourceType::PositionalRead)) {}
+
+		[[nodiscard]] size_t nReadsOf(uint64_t bid) const
+		{
+			return source.nReadsOf(file.blockIbs.at(bid));
+		}
+	};
+
+	TEST(MessageObjectTests, ProjectionOnlyReadsWhatItLists)
+	{
+		MessageFile file("storyt_message_projection_test.bin");
+		{
+			NDB ndb(file.source, file.file.header());
+			file.source.reset();
+			MessageObject message = MessageObject::Init(NID(MessageFile::messageNID), Ref<const NDB>(ndb),
+				Projection{ { PidTagTypeCombo::MessageSubject, PidTagTypeCombo::MessageSize } });
+			ASSERT_EQ(file.nReadsOf(MessageFile::recipBID), 0);
+			ASSERT_EQ(file.nReadsOf(MessageFile::attachBID), 0);
+			ASSERT_EQ(file.nReadsOf(MessageFile::bodyBID), 0);
+
+			ASSERT_EQ(message.getSubject(), "Subject");
+			ASSERT_EQ(message.getSize(), MessageFile::messageSize);
+			ASSERT_EQ(message.getDeliveryTime(), MessageFile::deliveryTime);
+			ASSERT_EQ(message.getBody(), MessageFile::body);
+			ASSERT_EQ(file.nReadsOf(MessageFile::bodyBID), 1);
+			ASSERT_EQ(file.nReadsOf(MessageFile::recipBID), 0);
+			ASSERT_EQ(file.nReadsOf(MessageFile::attachBID), 0);
+		}
+		{
+			// A listed property in the subnode tree is read while the message is opened
+			NDB ndb(file.source, file.file.header());
+			file.source.reset();
+			MessageObject message = MessageObject::Init(NID(MessageFile::messageNID), Ref<const NDB>(ndb),
+				Projection{ { PidTagTypeCombo::MessageBody } });
+			ASSERT_EQ(file.nReadsOf(MessageFile::bodyBID), 1);
+			ASSERT_EQ(message.getBody(), MessageFile::body);
+			ASSERT_EQ(file.nReadsOf(MessageFile::bodyBID), 1);
+			ASSERT_EQ(file.nReadsOf(MessageFile::recipBID), 0);
+			ASSERT_EQ(file.nReadsOf(MessageFile::attachBID), 0);
+		}
+	}
+
+	TEST(MessageObjectTests, UnprojectedTablesAreNotAnswered)
+	{
+		MessageFile file("storyt_message_unprojected_test.bin");
+		NDB ndb(file.source, file.file.header());
+		MessageObject message = MessageObject::Init(NID(MessageFile::messageNID), Ref<const NDB>(ndb), Projection{});
+#ifndef NDEBUG
+		ASSERT_DEATH(static_cast<void>(message.getRecipients()), "");
+		ASSERT_DEATH(static_cast<void>(message.hasAttachments()), "");
+#else
+		ASSERT_TRUE(message.getRecipients().empty());
+		ASSERT_FALSE(message.hasAttachments());
+#endif
+		ASSERT_EQ(file.nReadsOf(MessageFile::recipBID), 0);
+		ASSERT_EQ(file.nReadsOf(MessageFile::attachBID), 0);
+	}
+
+	TEST(MessageObjectTests, StreamsTheBodyInChunks)
+	{
+		MessageFile file("storyt_message_stream_test.bin");
+		NDB ndb(file.source, file.file.header());
+		MessageObject message = MessageObject::Init(NID(MessageFile::messageNID), Ref<const NDB>(ndb), Projection{});
+
+		// An odd sized buffer splits UTF-16 code units across chunks
+		std::vector<byte_t> buffer(5);
+		std::string streamed{};
+		size_t nChunks{ 0 };
+		const size_t nCharacters = message.streamBody(buffer, [&](std::string_view chunk) {
+			streamed += chunk;
+			++nChunks;
+		});
+		ASSERT_EQ(nCharacters, MessageFile::body.size());
+		ASSERT_EQ(streamed, MessageFile::body);
+		ASSERT_GT(nChunks, 1);
+		ASSERT_EQ(message.getBody(), MessageFile::body);
+	}
+
+}; // end namespace messaging_tests
@@ -3,12 +3,17 @@
 #include <stdarg.h>
 #include <cassert>
 #include <vector>
+#include <filesystem>
+#include <thread>
+#include <algorithm>
+#include <array>
 
 #include <gtest/gtest.h>
 
 #include "types.h"
 #include "utils.h"
 #include "core.h"
+#include "io.h"
 #include "ndb.h"
 
 namespace ndb_tests
@@ -17,6 +22,7 @@ namespace ndb_tests
 	using namespace storyt::utils;
 	using namespace storyt::core;
 	using namespace storyt::ndb;
+	using namespace storyt::io;
 
 	const std::vector<byte_t> sample_btpage = {
    0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -159,6 +165,34 @@ namespace ndb_tests
 	 0x80, 0x80, 0xD6, 0x00, 0x2F, 0xA0, 0xF6, 0xA1, 0x46, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Page Trailer
 	};
 
+	std::vector<byte_t> makeNBTPage(const std::vector<uint64_t>& keys, uint8_t cLevel)
+	{
+		// Builds a 512 byte NBT page. Leaf entries use the key as the NID and key + 1 as bidData.
+		// Intermediate entries use the key as the btkey and point to ib == key.
+		const uint8_t entrySize = cLevel == 0 ? 0x20 : 0x18;
+		std::vector<byte_t> page(BTPage::size, 0);
+		auto write = [&page](size_t offset, uint64_t value, size_t size) {
+			for (size_t i = 0; i < size; ++i)
+			{
+				page[offset + i] = static_cast<byte_t>(value >> (8 * i));
+			}
+		};
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			const size_t offset = i * entrySize;
+			write(offset, keys[i], 8);
+			write(offset + 8, keys[i] + 1, 8);
+			write(offset + 16, cLevel == 0 ? 0 : keys[i], 8);
+		}
+		page[488] = static_cast<byte_t>(keys.size());
+		page[489] = static_cast<byte_t>(488 / entrySize);
+		page[490] = entrySize;
+		page[491] = cLevel;
+		page[496] = 0x81; // ptypeNBT
+		page[497] = 0x81;
+		return page;
+	}
+
 	TEST(BTPageTest, BTPageTestInit)
 	{
 		const BTPage btpage = BTPage::Init(sample_btpage);
@@ -225,4 +259,987 @@ namespace ndb_tests
 			even += 2;
 		}
 	}
-};
\ No newline at end of file
+
+	TEST(BlockSourceTest, MappedAndPositionalSourcesMatch)
+	{
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_block_source_test.bin";
+		{
+			std::ofstream out(path, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(sample_btpage.data()), sample_btpage.size());
+			out.write(reinterpret_cast<const char*>(sample_nbtentryPage.data()), sample_nbtentryPage.size());
+		}
+		{
+			const std::unique_ptr<BlockSource> stream = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			const std::unique_ptr<BlockSource> mapped = BlockSource::Init(path.string(), SourceType::MemoryMapped);
+			ASSERT_EQ(stream->size(), mapped->size());
+
+			const Bytes streamBytes = stream->read(BTPage::size, BTPage::size);
+			const Bytes mappedBytes = mapped->read(BTPage::size, BTPage::size);
+			ASSERT_EQ(streamBytes.isOwned(), true);
+			ASSERT_EQ(mappedBytes.isOwned(), false);
+			ASSERT_TRUE(std::equal(streamBytes.view().begin(), streamBytes.view().end(), mappedBytes.view().begin()));
+
+			const BTPage nbtpage = BTPage::Init(mappedBytes.view());
+			ASSERT_EQ(nbtpage.nEntries, 0x05);
+			ASSERT_EQ(nbtpage.hasNBTEntries(), true);
+			ASSERT_EQ(nbtpage.get<NBTEntry>(NID(5)).value().bidData, BID(6));
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(BlockSourceTest, OpeningAMissingFileThrows)
+	{
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_missing_source_test.bin";
+		std::filesystem::remove(path);
+		for (const SourceType type : { SourceType::PositionalRead, SourceType::MemoryMapped, SourceType::IOUring })
+		{
+			ASSERT_THROW(static_cast<void>(BlockSource::Init(path.string(), type)), std::system_error);
+		}
+	}
+
+	TEST(BlockSourceTest, ReadsPastTheEndThrow)
+	{
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_short_read_test.bin";
+		{
+			std::ofstream out(path, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(sample_btpage.data()), sample_btpage.size());
+		}
+		for (const SourceType type : { SourceType::PositionalRead, SourceType::MemoryMapped, SourceType::IOUring })
+		{
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), type);
+			ASSERT_EQ(source->read(0, sample_btpage.size()).size(), sample_btpage.size());
+			ASSERT_THROW(static_cast<void>(source->read(1, sample_btpage.size())), std::system_error);
+			ASSERT_THROW(static_cast<void>(source->read(sample_btpage.size() + 1, 0)), std::system_error);
+			const std::vector<ReadRequest> requests{ { 0, 64 }, { sample_btpage.size() - 8, 64 } };
+			ASSERT_THROW(static_cast<void>(source->readBatch(requests)), std::system_error);
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(BlockSourceTest, BatchedReadsMatchSingleReads)
+	{
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_batched_read_test.bin";
+		std::vector<byte_t> contents(256 * 1024);
+		for (size_t i = 0; i < contents.size(); ++i)
+		{
+			contents[i] = static_cast<byte_t>((i * 131U) ^ (i >> 10U));
+		}
+		{
+			std::ofstream out(path, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		}
+		{
+			// More requests than the io_uring has entries so the batch is split.
+			std::vector<ReadRequest> requests{};
+			for (uint64_t i = 0; i < 150; ++i)
+			{
+				requests.push_back({ (i * 7919U * 64U) % (contents.size() - 8192U), 64U * (1U + i % 128U) });
+			}
+			for (const SourceType type : { SourceType::PositionalRead, SourceType::MemoryMapped, SourceType::IOUring })
+			{
+				const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), type);
+				const std::vector<Bytes> batch = source->readBatch(requests);
+				ASSERT_EQ(batch.size(), requests.size());
+				for (size_t i = 0; i < requests.size(); ++i)
+				{
+					ASSERT_EQ(batch[i].size(), requests[i].nBytes);
+					ASSERT_TRUE(std::equal(batch[i].view().begin(), batch[i].view().end(), contents.begin() + requests[i].position));
+				}
+			}
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(ReadSchedulerTest, MergesNearbyReadsAndSplitsThemBack)
+	{
+		const ReadScheduler scheduler(64, 1024);
+		// Out of order, touching, overlapping, within the gap, past the gap and past maxRead.
+		const std::vector<ReadRequest> requests{
+			{ 512, 64 }, { 0, 64 }, { 64, 128 }, { 128, 32 }, { 224, 64 }, { 4096, 64 }, { 4160, 1024 }
+		};
+		const std::vector<ReadRequest> plan = scheduler.plan(requests);
+		ASSERT_EQ(plan.size(), 4);
+		ASSERT_EQ(plan[0].position, 0);
+		ASSERT_EQ(plan[0].nBytes, 288);
+		ASSERT_EQ(plan[1].position, 512);
+		ASSERT_EQ(plan[1].nBytes, 64);
+		ASSERT_EQ(plan[2].position, 4096);
+		ASSERT_EQ(plan[2].nBytes, 64);
+		ASSERT_EQ(plan[3].position, 4160);
+
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_read_scheduler_test.bin";
+		std::vector<byte_t> contents(8192);
+		for (size_t i = 0; i < contents.size(); ++i)
+		{
+			contents[i] = static_cast<byte_t>((i * 29U) ^ (i >> 7U));
+		}
+		{
+			std::ofstream out(path, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		}
+		{
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			const std::vector<Bytes> bytes = scheduler.read(*source, requests);
+			ASSERT_EQ(bytes.size(), requests.size());
+			for (size_t i = 0; i < requests.size(); ++i)
+			{
+				ASSERT_EQ(bytes[i].size(), requests[i].nBytes);
+				ASSERT_TRUE(std::equal(bytes[i].view().begin(), bytes[i].view().end(), contents.begin() + requests[i].position));
+			}
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(BlockSourceTest, ConcurrentPositionalReads)
+	{
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_concurrent_read_test.bin";
+		std::vector<byte_t> contents(64 * 1024);
+		for (size_t i = 0; i < contents.size(); ++i)
+		{
+			contents[i] = static_cast<byte_t>((i * 31U) ^ (i >> 8U));
+		}
+		{
+			std::ofstream out(path, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		}
+		{
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			std::vector<int> mismatches(8, 0);
+			std::vector<std::thread> workers;
+			for (size_t t = 0; t < mismatches.size(); ++t)
+			{
+				workers.emplace_back([&, t]() {
+					for (size_t i = 0; i < 500; ++i)
+					{
+						const uint64_t position = ((t * 7919U + i * 104729U) % (contents.size() - 512U));
+						const Bytes bytes = source->read(position, 512);
+						if (!std::equal(bytes.view().begin(), bytes.view().end(), contents.begin() + position))
+						{
+							++mismatches[t];
+						}
+					}
+				});
+			}
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+			for (const int n : mismatches)
+			{
+				ASSERT_EQ(n, 0);
+			}
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(BTPageTest, LazyChildPageLookup)
+	{
+		const BTPage root = BTPage::Init(makeNBTPage({ 0x20, 0x400, 0x800 }, 1));
+		std::vector<uint64_t> loaded{};
+		const BTPage::GetPage_t getPage = [&loaded](const BREF& bref, int32_t parentCLevel) {
+			loaded.push_back(bref.ib);
+			const std::vector<uint64_t> nids = { bref.ib, bref.ib + 0x20, bref.ib + 0x40 };
+			return std::make_shared<const BTPage>(BTPage::Init(makeNBTPage(nids, 0), parentCLevel));
+		};
+
+		const std::optional<NBTEntry> nbt = root.get<NBTEntry>(NID(0x420), getPage);
+		ASSERT_TRUE(nbt.has_value());
+		ASSERT_EQ(nbt.value().bidData, BID(0x421));
+		// Only the one child page that can hold the NID is read
+		ASSERT_EQ(loaded.size(), 1);
+		ASSERT_EQ(loaded.at(0), 0x400);
+
+		ASSERT_FALSE(root.get<NBTEntry>(NID(0x10), getPage).has_value());
+		ASSERT_EQ(loaded.size(), 1);
+	}
+
+	TEST(BTPageTest, PageCacheEvictsLeastRecentlyUsed)
+	{
+		const size_t pageBytes = BTPage::Init(makeNBTPage({ 0x20 }, 0)).nBytesInMemory();
+		PageCache cache(pageBytes * 2);
+		size_t nLoads{ 0 };
+		auto load = [&nLoads](uint64_t key) {
+			return [&nLoads, key]() { ++nLoads; return BTPage::Init(makeNBTPage({ key }, 0)); };
+		};
+
+		std::shared_ptr<const BTPage> first = cache.get(1, load(0x20));
+		ASSERT_EQ(cache.get(2, load(0x40))->rgentries.size(), 1);
+		ASSERT_EQ(cache.get(1, load(0x20)), first); // hit, 1 is now the most recently used
+		ASSERT_EQ(nLoads, 2);
+
+		ASSERT_EQ(cache.get(3, load(0x60))->rgentries.size(), 1); // evicts 2
+		ASSERT_EQ(cache.nPages(), 2);
+		ASSERT_LE(cache.nBytes(), cache.byteBudget());
+
+		ASSERT_EQ(cache.get(1, load(0x20)), first);
+		ASSERT_EQ(nLoads, 3);
+		ASSERT_EQ(cache.get(2, load(0x40))->rgentries.size(), 1);
+		ASSERT_EQ(nLoads, 4);
+	}
+
+	TEST(BTPageTest, FlattenedIndexMatchesTree)
+	{
+		std::vector<uint64_t> rootKeys{};
+		for (uint64_t i = 0; i < 20; ++i)
+		{
+			rootKeys.push_back((i + 1) * 0x1000);
+		}
+		const BTPage root = BTPage::Init(makeNBTPage(rootKeys, 1));
+		std::vector<std::shared_ptr<const BTPage>> leaves{};
+		const BTPage::GetPage_t getPage = [&leaves](const BREF& bref, int32_t parentCLevel) {
+			std::vector<uint64_t> nids{};
+			for (uint64_t i = 0; i < 15; ++i)
+			{
+				nids.push_back(bref.ib + (i * 0x20));
+			}
+			leaves.push_back(std::make_shared<const BTPage>(BTPage::Init(makeNBTPage(nids, 0), parentCLevel)));
+			return leaves.back();
+		};
+
+		const NBTIndex index = NBTIndex::Init(root, getPage);
+		ASSERT_EQ(index.size(), 20 * 15);
+		size_t treeBytes = root.nBytesInMemory();
+		for (const auto& leaf : leaves)
+		{
+			treeBytes += leaf->nBytesInMemory();
+		}
+		ASSERT_LT(index.nBytesInMemory() * 3, treeBytes);
+
+		for (uint64_t key : rootKeys)
+		{
+			for (uint64_t i = 0; i < 15; ++i)
+			{
+				const NID nid(static_cast<uint32_t>(key + (i * 0x20)));
+				const std::optional<NBTEntry> flat = index.get(nid);
+				const std::optional<NBTEntry> tree = root.get<NBTEntry>(nid, getPage);
+				ASSERT_TRUE(flat.has_value());
+				ASSERT_EQ(flat.value().nid, tree.value().nid);
+				ASSERT_EQ(flat.value().bidData, tree.value().bidData);
+				ASSERT_EQ(flat.value().bidSub, tree.value().bidSub);
+			}
+		}
+		ASSERT_FALSE(index.get(NID(0x10)).has_value());
+		ASSERT_FALSE(index.get(NID(0x1010)).has_value());
+		ASSERT_FALSE(index.get(NID(0xFFFFFF)).has_value());
+
+		const BTPage bbtpage = BTPage::Init(sample_bbtentryPage);
+		const BBTIndex bbtIndex = BBTIndex::Init(bbtpage, nullptr);
+		ASSERT_EQ(bbtIndex.size(), 5);
+		for (const auto& entry : bbtpage.rgentries)
+		{
+			const BBTEntry expected = entry.asBBTEntry();
+			const BBTEntry bbt = bbtIndex.get(expected.bref.bid).value();
+			ASSERT_EQ(bbt.bref.ib, expected.bref.ib);
+			ASSERT_EQ(bbt.cb, expected.cb);
+			ASSERT_EQ(bbt.cRef, expected.cRef);
+		}
+		ASSERT_FALSE(bbtIndex.get(BID(3)).has_value());
+	}
+
+	std::vector<byte_t> makeBlockBytes(const std::vector<byte_t>& data, uint64_t bid, uint64_t ib = 0)
+	{
+		// The data followed by padding and the 16 byte block trailer, rounded up to a multiple of 64 bytes.
+		const size_t trailerOffset = ((data.size() + 16 + 63) / 64) * 64 - 16;
+		std::vector<byte_t> block(trailerOffset + 16, 0);
+		std::copy(data.begin(), data.end(), block.begin());
+		const uint32_t crc = static_cast<uint32_t>(storyt::utils::ms::ComputeCRC(0, block.data(), static_cast<uint32_t>(data.size())));
+		auto write = [&block](size_t offset, uint64_t value, size_t size) {
+			for (size_t i = 0; i < size; ++i)
+			{
+				block[offset + i] = static_cast<byte_t>(value >> (8 * i));
+			}
+		};
+		write(trailerOffset, data.size(), 2);
+		write(trailerOffset + 2, storyt::utils::ms::ComputeSig(ib, bid), 2);
+		write(trailerOffset + 4, crc, 4);
+		write(trailerOffset + 8, bid, 8);
+		return block;
+	}
+
+	std::shared_ptr<const DataBlock> makeDataBlock(byte_t fill)
+	{
+		std::vector<byte_t> block = makeBlockBytes(std::vector<byte_t>(8, fill), 0);
+		BlockTrailer trailer(std::span<const byte_t>(block).subspan(48, 16));
+		return std::make_shared<const DataBlock>(Bytes(std::move(block)), std::move(trailer));
+	}
+
+	TEST(DataBlockTest, DecodesEveryCryptMethod)
+	{
+		std::vector<byte_t> plain(40);
+		for (size_t i = 0; i < plain.size(); ++i)
+		{
+			plain[i] = static_cast<byte_t>(i * 37);
+		}
+		const uint64_t bid = 0x12345678ABCDULL;
+		auto decode = [&](const std::vector<byte_t>& bytes, CryptMethod cryptMethod) {
+			const std::span<const byte_t> view(bytes);
+			return DataBlock(Bytes(view), BlockTrailer(view.subspan(48, 16)), cryptMethod);
+		};
+
+		// NONE borrows the bytes it was given instead of copying them.
+		const std::vector<byte_t> none = makeBlockBytes(plain, bid);
+		const DataBlock noneBlock = decode(none, CryptMethod::NONE);
+		ASSERT_EQ(noneBlock.data().data(), none.data());
+		ASSERT_TRUE(std::ranges::equal(noneBlock.data(), plain));
+
+		std::vector<byte_t> permuted(plain);
+		storyt::utils::ms::CryptPermute(permuted.data(), static_cast<int>(permuted.size()), storyt::utils::ms::ENCODE_DATA);
+		ASSERT_TRUE(std::ranges::equal(decode(makeBlockBytes(permuted, bid), CryptMethod::PERMUTE).data(), plain));
+
+		std::vector<byte_t> cyclic(plain);
+		storyt::utils::ms::CryptCyclic(cyclic.data(), static_cast<int>(cyclic.size()), static_cast<uint32_t>(bid));
+		ASSERT_TRUE(std::ranges::equal(decode(makeBlockBytes(cyclic, bid), CryptMethod::CYCLIC).data(), plain));
+	}
+
+	TEST(DataBlockTest, DecodeIntoRejectsATrailerThatDoesNotFit)
+	{
+		const uint64_t bid = 0x40;
+		const std::vector<byte_t> plain(40, 0x7A);
+		std::vector<byte_t> out(40);
+		ASSERT_EQ(DataBlock::DecodeInto(makeBlockBytes(plain, bid), BREF(bid, 0), CryptMethod::NONE, true, out).cb, 40);
+		ASSERT_EQ(out, plain);
+
+		// The BBT says 40 bytes but the trailer claims more
+		std::vector<byte_t> corrupt = makeBlockBytes(plain, bid);
+		corrupt[48] = 60; // cb
+		std::vector<byte_t> small(40);
+		ASSERT_THROW(DataBlock::DecodeInto(corrupt, BREF(bid, 0), CryptMethod::NONE, false, small), std::runtime_error);
+		std::vector<byte_t> large(60);
+		ASSERT_THROW(DataBlock::DecodeInto(std::span<const byte_t>(corrupt).last(32), BREF(bid, 0), CryptMethod::NONE, false, large), std::runtime_error);
+	}
+
+	/// An XBlock at ib 0 pointing at 3 data blocks of 40 bytes that follow it in the file.
+	struct XBlockFile
+	{
+		static constexpr uint64_t xbid = 0x22;
+		std::filesystem::path path{};
+		std::vector<byte_t> xblockData{ 0x01, 0x01, 0x03, 0x00, 120, 0, 0, 0 };
+		std::vector<byte_t> expected{};
+		std::unordered_map<uint64_t, BBTEntry> bbts{};
+
+		explicit XBlockFile(const std::string& name)
+			: path(std::filesystem::temp_directory_path() / name)
+		{
+			std::vector<std::vector<byte_t>> blocks{};
+			for (uint64_t i = 1; i <= 3; ++i)
+			{
+				const uint64_t bid = i * 4;
+				std::vector<byte_t> data(40);
+				for (size_t j = 0; j < data.size(); ++j)
+				{
+					data[j] = static_cast<byte_t>(i * 50 + j);
+				}
+				expected.insert(expected.end(), data.begin(), data.end());
+				for (size_t b = 0; b < 8; ++b)
+				{
+					xblockData.push_back(static_cast<byte_t>(bid >> (8 * b)));
+				}
+				bbts[bid] = BBTEntry{ BREF(bid, i * 64), 40 };
+				blocks.push_back(makeBlockBytes(data, bid, i * 64));
+			}
+			std::ofstream out(path, std::ios::binary);
+			for (const auto& block : { makeBlockBytes(xblockData, xbid, 0), blocks[0], blocks[1], blocks[2] })
+			{
+				out.write(reinterpret_cast<const char*>(block.data()), block.size());
+			}
+		}
+		~XBlockFile()
+		{
+			std::filesystem::remove(path);
+		}
+
+		[[nodiscard]] DataTree::GetBBT_t getBBT() const
+		{
+			return [this](const BID& bid) -> std::optional<BBTEntry> { return bbts.at(bid.getBidRaw()); };
+		}
+	};
+
+	TEST(DataTreeReaderTest, StreamsEveryBlockOfAnXBlock)
+	{
+		const XBlockFile file("storyt_datatree_reader_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		const DataTree tree(Ref<const BlockSource>(*source), file.getBBT(), BREF(XBlockFile::xbid, 0), file.xblockData.size(), CryptMethod::NONE);
+
+		DataTreeReader reader(tree);
+		ASSERT_EQ(reader.size(), file.expected.size());
+		std::vector<byte_t> streamed{};
+		// A buffer size that does not line up with the blocks.
+		std::array<byte_t, 7> buffer{};
+		for (size_t n = reader.read(buffer); n != 0; n = reader.read(buffer))
+		{
+			streamed.insert(streamed.end(), buffer.begin(), buffer.begin() + n);
+		}
+		ASSERT_TRUE(reader.done());
+		ASSERT_EQ(streamed, file.expected);
+		ASSERT_EQ(DataTree(tree).load().combineDataBlocks(), file.expected);
+	}
+
+	TEST(DataTreeReaderTest, DecodesWholeBlocksStraightIntoTheBuffer)
+	{
+		const XBlockFile file("storyt_datatree_reader_direct_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		const DataTree tree(Ref<const BlockSource>(*source), file.getBBT(), BREF(XBlockFile::xbid, 0), file.xblockData.size(), CryptMethod::NONE);
+
+		// 50 fits one block and splits the next, 120 fits every block and 200 is bigger than the data.
+		for (const size_t bufferSize : { 40, 50, 120, 200 })
+		{
+			DataTreeReader reader(tree);
+			std::vector<byte_t> buffer(bufferSize);
+			std::vector<byte_t> streamed{};
+			for (size_t n = reader.read(buffer); n != 0; n = reader.read(buffer))
+			{
+				streamed.insert(streamed.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(n));
+			}
+			ASSERT_TRUE(reader.done());
+			ASSERT_EQ(streamed, file.expected);
+		}
+
+		// A DataTree that is a single data block
+		const DataTree single(Ref<const BlockSource>(*source), file.getBBT(), BREF(8, 128), 40, CryptMethod::NONE);
+		DataTreeReader reader(single);
+		ASSERT_EQ(reader.size(), 40);
+		std::vector<byte_t> buffer(64);
+		ASSERT_EQ(reader.read(buffer), 40);
+		ASSERT_TRUE(std::equal(buffer.begin(), buffer.begin() + 40, file.expected.begin() + 40));
+		ASSERT_EQ(reader.read(buffer), 0);
+	}
+
+	TEST(DataTreeTest, ReadRangeMatchesTheLoadedData)
+	{
+		const XBlockFile file("storyt_datatree_range_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		DataTree lazy(Ref<const BlockSource>(*source), file.getBBT(), BREF(XBlockFile::xbid, 0), file.xblockData.size(), CryptMethod::NONE);
+		DataTree loaded(lazy);
+		loaded.load();
+		ASSERT_EQ(lazy.sizeOfData(), file.expected.size());
+
+		std::vector<byte_t> out(64);
+		for (const auto& [offset, size] : std::vector<std::pair<size_t, size_t>>{ { 0, 10 }, { 35, 10 }, { 39, 42 }, { 40, 40 }, { 100, 64 }, { 120, 8 } })
+		{
+			const std::span<byte_t> range(out.data(), size);
+			const size_t expectedSize = std::min(offset + size, file.expected.size()) - std::min(offset, file.expected.size());
+			ASSERT_EQ(lazy.readRange(offset, range), expectedSize);
+			ASSERT_TRUE(std::equal(out.begin(), out.begin() + expectedSize, file.expected.begin() + offset));
+			ASSERT_EQ(loaded.readRange(offset, range), expectedSize);
+			ASSERT_TRUE(std::equal(out.begin(), out.begin() + expectedSize, file.expected.begin() + offset));
+		}
+	}
+
+	TEST(DataTreeTest, ReopensMultiBlockTreesFromTheBlockCache)
+	{
+		const XBlockFile file("storyt_datatree_cache_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		BlockCache cache{};
+		auto open = [&]() {
+			return DataTree(Ref<const BlockSource>(*source), file.getBBT(), BREF(XBlockFile::xbid, 0), 
+				file.xblockData.size(), CryptMethod::NONE, ReadOptions{}, &cache);
+		};
+		DataTree first = open();
+		first.load();
+		ASSERT_EQ(cache.nBlocks(), 3);
+		ASSERT_TRUE(std::ranges::equal(first.data(), file.expected));
+		// The cached blocks view the tree's buffer instead of holding a decoded copy of their own
+		ASSERT_EQ(cache.find(BID(8))->data().data(), first.data().data() + 40);
+		ASSERT_GE(cache.nBytes(), file.expected.size());
+
+		// Zero the data blocks on disk. Reopening still has the data because it comes from the cache.
+		{
+			std::fstream out(file.path, std::ios::binary | std::ios::in | std::ios::out);
+			out.seekp(64);
+			const std::vector<char> zeros(3 * 64, 0);
+			out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+		}
+		DataTree reopened = open();
+		reopened.load();
+		ASSERT_TRUE(std::ranges::equal(reopened.data(), file.expected));
+	}
+
+	TEST(DataTreeTest, BlocksAreViewsIntoOneSharedBuffer)
+	{
+		const XBlockFile file("storyt_datatree_buffer_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		DataTree tree(Ref<const BlockSource>(*source), file.getBBT(), BREF(XBlockFile::xbid, 0), file.xblockData.size(), CryptMethod::NONE);
+		tree.load();
+		ASSERT_EQ(tree.nDataBlocks(), 3);
+		ASSERT_TRUE(std::equal(tree.data().begin(), tree.data().end(), file.expected.begin(), file.expected.end()));
+		for (size_t i = 0; i < tree.nDataBlocks(); ++i)
+		{
+			ASSERT_EQ(tree.blockData(i).size(), tree.sizeOfDataBlockData(i));
+			ASSERT_EQ(tree.blockData(i).data(), tree.data().data() + i * 40);
+		}
+
+		// A copy shares the buffer so views taken from either stay valid while one of them is alive.
+		const std::span<const byte_t> view = tree.blockData(1);
+		const DataTree copy(tree);
+		tree = DataTree(Ref<const BlockSource>(*source), file.getBBT(), BREF(XBlockFile::xbid, 0), file.xblockData.size(), CryptMethod::NONE);
+		ASSERT_EQ(copy.blockData(1).data(), view.data());
+		ASSERT_TRUE(std::equal(view.begin(), view.end(), file.expected.begin() + 40));
+	}
+
+	/// The data of an SLBlock with an SLEntry for every { nid, bidData, bidSub }.
+	std::vector<byte_t> makeSLBlockData(const std::vector<std::array<uint64_t, 3>>& entries)
+	{
+		std::vector<byte_t> slData{ 0x02, 0x00, static_cast<byte_t>(entries.size()), 0x00, 0, 0, 0, 0 };
+		for (const auto& entry : entries)
+		{
+			for (const uint64_t value : entry)
+			{
+				for (size_t b = 0; b < 8; ++b)
+				{
+					slData.push_back(static_cast<byte_t>(value >> (8 * b)));
+				}
+			}
+		}
+		return slData;
+	}
+
+	/// The data of an SLBlock with a single SLEntry.
+	std::vector<byte_t> makeSLBlockData(uint64_t nid, uint64_t bidData, uint64_t bidSub)
+	{
+		return makeSLBlockData({ { nid, bidData, bidSub } });
+	}
+
+	void writeBlocks(const std::filesystem::path& path, const std::vector<std::vector<byte_t>>& blocks)
+	{
+		std::ofstream out(path, std::ios::binary);
+		for (const auto& block : blocks)
+		{
+			out.write(reinterpret_cast<const char*>(block.data()), block.size());
+		}
+	}
+
+	TEST(SubNodeBTreeTest, ResolvesDataTreesOnFirstUse)
+	{
+		// An SLBlock at ib 0 with a single entry pointing at a data block of 40 bytes at ib 64.
+		const uint64_t slbid = 0x32;
+		const uint64_t dataBid = 0x4;
+		const std::vector<byte_t> slData = makeSLBlockData(0x1, dataBid, 0x0);
+		const std::vector<byte_t> data(40, 0x5A);
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_subnode_lazy_test.bin";
+		writeBlocks(path, { makeBlockBytes(slData, slbid, 0), makeBlockBytes(data, dataBid, 64) });
+
+		size_t nLookups{ 0 };
+		const std::unordered_map<uint64_t, BBTEntry> bbts{ { slbid, BBTEntry{ BREF(slbid, 0), static_cast<uint16_t>(slData.size()) } }, { dataBid, BBTEntry{ BREF(dataBid, 64), 40 } } };
+		const SubNodeBTree::GetBBT_t getBBT = [&](const BID& bid) -> std::optional<BBTEntry> {
+			++nLookups;
+			return bbts.at(bid.getBidRaw());
+		};
+		{
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			SubNodeBTree tree(BID{ slbid }, Ref<const BlockSource>(*source), getBBT, CryptMethod::NONE);
+			ASSERT_EQ(nLookups, 1); // Only the SLBlock itself
+
+			ASSERT_EQ(tree.getNestedSubNodeTree(NID(0x1)), nullptr);
+			ASSERT_EQ(tree.getDataTree(NID(0x2)), nullptr);
+			ASSERT_EQ(nLookups, 1);
+
+			DataTree* dataTree = tree.getDataTree(NID(0x1));
+			ASSERT_NE(dataTree, nullptr);
+			ASSERT_EQ(nLookups, 2);
+			ASSERT_EQ(dataTree->combineDataBlocks(), data);
+			ASSERT_EQ(tree.getDataTree(NID(0x1)), dataTree);
+			ASSERT_EQ(nLookups, 2);
+		}
+		std::filesystem::remove(path);
+	}
+
+	/**
+	 * @brief Writes SLBlock i at ib i * 256 followed by its 40 byte data block, filled with i + 1, at ib i * 256 + 128.
+	 * @return The BBTEntries of every block written
+	*/
+	std::unordered_map<uint64_t, BBTEntry> writeSLBlocks(const std::filesystem::path& path,
+		const std::vector<std::vector<byte_t>>& slData, const std::vector<uint64_t>& slbids, const std::vector<uint64_t>& dataBids)
+	{
+		std::unordered_map<uint64_t, BBTEntry> bbts{};
+		std::vector<std::vector<byte_t>> blocks{};
+		for (size_t i = 0; i < slData.size(); ++i)
+		{
+			bbts[slbids[i]] = BBTEntry{ BREF(slbids[i], i * 256), static_cast<uint16_t>(slData[i].size()) };
+			bbts[dataBids[i]] = BBTEntry{ BREF(dataBids[i], i * 256 + 128), 40 };
+			blocks.push_back(makeBlockBytes(slData[i], slbids[i], i * 256));
+			blocks.push_back(std::vector<byte_t>(128 - blocks.back().size(), 0));
+			blocks.push_back(makeBlockBytes(std::vector<byte_t>(40, static_cast<byte_t>(i + 1)), dataBids[i], i * 256 + 128));
+			blocks.push_back(std::vector<byte_t>(128 - blocks.back().size(), 0));
+		}
+		writeBlocks(path, blocks);
+		return bbts;
+	}
+
+	TEST(SubNodeBTreeTest, FindsNestedNIDsOneLevelAtATime)
+	{
+		// SL 0x32 -> { nid 0x1, data 0x4, sub 0x42 }, SL 0x42 -> { nid 0x2, data 0x8, sub 0x52 }, SL 0x52 -> { nid 0x1, data 0xC, sub 0 }
+		const std::vector<std::vector<byte_t>> slData{ makeSLBlockData(0x1, 0x4, 0x42), makeSLBlockData(0x2, 0x8, 0x52), makeSLBlockData(0x1, 0xC, 0x0) };
+		const std::vector<uint64_t> slbids{ 0x32, 0x42, 0x52 };
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_subnode_index_test.bin";
+		const std::unordered_map<uint64_t, BBTEntry> bbts = writeSLBlocks(path, slData, slbids, { 0x4, 0x8, 0xC });
+		{
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			const SubNodeBTree::GetBBT_t getBBT = [&bbts](const BID& bid) -> std::optional<BBTEntry> { return bbts.at(bid.getBidRaw()); };
+			SubNodeBTree tree(BID{ slbids[0] }, Ref<const BlockSource>(*source), getBBT, CryptMethod::NONE);
+
+			// nid 0x1 is in this tree and in the deepest one. The shallowest entry wins.
+			ASSERT_EQ(tree.getDataTree(NID(0x1))->combineDataBlocks(), std::vector<byte_t>(40, 1));
+			ASSERT_EQ(tree.getDataTree(NID(0x2))->combineDataBlocks(), std::vector<byte_t>(40, 2));
+			ASSERT_EQ(tree.getDataTree(NID(0x3)), nullptr);
+			ASSERT_TRUE(tree.getDataTreeReader(NID(0x2)).has_value());
+			ASSERT_NE(tree.getNestedSubNodeTree(NID(0x1)), nullptr);
+			ASSERT_EQ(tree.getNestedSubNodeTree(NID(0x2)), nullptr); // Only this tree's own entries have nested trees
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(SubNodeBTreeTest, RepeatedNestedNIDsResolveToTheFirstParent)
+	{
+		// SL 0x32 -> { 0x1 sub 0x52 } { 0x2 sub 0x42 }
+		//   SL 0x52 (under 0x1) -> { 0x10 sub 0x62 }
+		//     SL 0x62 -> { 0x20 }
+		//   SL 0x42 (under 0x2) -> { 0x10 } { 0x11 }
+		const std::vector<std::vector<byte_t>> slData{
+			makeSLBlockData({ { 0x1, 0x4, 0x52 }, { 0x2, 0x4, 0x42 } }),
+			makeSLBlockData({ { 0x10, 0x8, 0x0 }, { 0x11, 0x8, 0x0 } }),
+			makeSLBlockData({ { 0x10, 0xC, 0x62 } }),
+			makeSLBlockData(0x20, 0x10, 0x0)
+		};
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_subnode_repeated_test.bin";
+		const std::unordered_map<uint64_t, BBTEntry> bbts = writeSLBlocks(path, slData, { 0x32, 0x42, 0x52, 0x62 }, { 0x4, 0x8, 0xC, 0x10 });
+		{
+			std::unordered_map<uint64_t, size_t> nLookups{};
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			const SubNodeBTree::GetBBT_t getBBT = [&](const BID& bid) -> std::optional<BBTEntry> {
+				++nLookups[bid.getBidRaw()];
+				return bbts.at(bid.getBidRaw());
+			};
+			SubNodeBTree tree(BID(0x32), Ref<const BlockSource>(*source), getBBT, CryptMethod::NONE);
+
+			// Both nested trees hold 0x10. The one under 0x1 wins even though its block comes later in the file.
+			ASSERT_EQ(tree.getDataTree(NID(0x10))->combineDataBlocks(), std::vector<byte_t>(40, 3));
+			ASSERT_EQ(tree.getDataTree(NID(0x11))->combineDataBlocks(), std::vector<byte_t>(40, 2));
+			ASSERT_EQ(nLookups[0x62], 0); // Found one level down so the level below it is never read
+
+			ASSERT_EQ(tree.getDataTree(NID(0x20))->combineDataBlocks(), std::vector<byte_t>(40, 4));
+			ASSERT_EQ(nLookups[0x62], 1);
+			ASSERT_EQ(tree.getDataTree(NID(0x30)), nullptr);
+			ASSERT_EQ(nLookups[0x62], 1);
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(SubNodeBTreeTest, ConcurrentLookupsOnAConstTree)
+	{
+		const std::vector<std::vector<byte_t>> slData{ makeSLBlockData(0x1, 0x4, 0x42), makeSLBlockData(0x2, 0x8, 0x52), makeSLBlockData(0x3, 0xC, 0x0) };
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "storyt_subnode_concurrent_test.bin";
+		const std::unordered_map<uint64_t, BBTEntry> bbts = writeSLBlocks(path, slData, { 0x32, 0x42, 0x52 }, { 0x4, 0x8, 0xC });
+		{
+			const std::unique_ptr<BlockSource> source = BlockSource::Init(path.string(), SourceType::PositionalRead);
+			const SubNodeBTree::GetBBT_t getBBT = [&bbts](const BID& bid) -> std::optional<BBTEntry> { return bbts.at(bid.getBidRaw()); };
+			const SubNodeBTree tree(BID(0x32), Ref<const BlockSource>(*source), getBBT, CryptMethod::NONE);
+
+			// Every thread resolves the same nested trees and DataTrees for the first time at once.
+			std::vector<int> mismatches(8, 0);
+			std::vector<const SubNodeBTree*> nested(mismatches.size(), nullptr);
+			std::vector<std::thread> workers;
+			for (size_t t = 0; t < mismatches.size(); ++t)
+			{
+				workers.emplace_back([&, t]() {
+					nested[t] = tree.getNestedSubNodeTree(NID(0x1));
+					for (const uint32_t nid : { 0x3U, 0x1U, 0x2U })
+					{
+						std::optional<DataTreeReader> reader = tree.getDataTreeReader(NID(nid));
+						std::vector<byte_t> data(40, 0);
+						if (!reader.has_value() || reader->read(data) != data.size() || data != std::vector<byte_t>(40, static_cast<byte_t>(nid)))
+						{
+							++mismatches[t];
+						}
+					}
+				});
+			}
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+			for (size_t t = 0; t < mismatches.size(); ++t)
+			{
+				ASSERT_EQ(mismatches[t], 0);
+				ASSERT_NE(nested[t], nullptr);
+				ASSERT_EQ(nested[t], nested[0]);
+			}
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST(SequentialScanTest, RebuildsNodesFromBlocksInFileOrder)
+	{
+		const XBlockFile file("storyt_sequential_scan_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		std::vector<BBTEntry> blocks{ BBTEntry{ BREF(XBlockFile::xbid, 0), static_cast<uint16_t>(file.xblockData.size()) } };
+		for (const auto& [bid, bbt] : file.bbts)
+		{
+			blocks.push_back(bbt);
+		}
+		// An SLBlock past the end of the file. Reading it would throw so the scan must never read it.
+		blocks.push_back(BBTEntry{ BREF(0x26, 1ULL << 20U), 64 });
+		// A chunk smaller than two blocks so the scan takes several reads.
+		SequentialScan scan(*source, blocks, CryptMethod::NONE, ReadOptions{}, 100);
+		scan.addNode(1, BID(XBlockFile::xbid));
+		// Shares its only block with the XBlock's DataTree.
+		scan.addNode(2, BID(8));
+		// Neither block is in the BBT
+		scan.addNode(3, BID(0x30));
+		scan.addNode(4, BID(0x32));
+		std::unordered_map<uint64_t, std::vector<byte_t>> nodes{};
+		const std::vector<uint64_t> notRebuilt = scan.run([&nodes](uint64_t key, std::vector<byte_t>&& data) { nodes[key] = std::move(data); });
+
+		ASSERT_EQ(notRebuilt, std::vector<uint64_t>({ 3, 4 }));
+		ASSERT_EQ(nodes.size(), 2);
+		ASSERT_EQ(nodes.at(1), file.expected);
+		ASSERT_EQ(nodes.at(2), std::vector<byte_t>(file.expected.begin() + 40, file.expected.begin() + 80));
+	}
+
+	TEST(ReadOptionsTest, TrustedSkipsChecksAndSamplesAreStable)
+	{
+		const std::vector<byte_t> plain(40, 0x7A);
+		std::vector<byte_t> corrupt = makeBlockBytes(plain, 0x40);
+		corrupt[52] ^= 0xFF; // dwCRC
+		corrupt[50] ^= 0xFF; // wSig
+		const DataBlock block = DataBlock::Init(Bytes(std::move(corrupt)), BREF(0x40, 0x1000), CryptMethod::NONE, false);
+		ASSERT_TRUE(std::ranges::equal(block.data(), plain));
+
+		const ReadOptions full{};
+		const ReadOptions trusted = ReadOptions::Trusted();
+		ReadOptions sampled{};
+		sampled.ndb = Validation::Sampled;
+		size_t nSampled{ 0 };
+		for (uint64_t bid = 4; bid < 4 * 1600; bid += 4)
+		{
+			ASSERT_TRUE(full.shouldValidate(full.ndb, bid));
+			ASSERT_FALSE(trusted.shouldValidate(trusted.ndb, bid));
+			ASSERT_EQ(sampled.shouldValidate(sampled.ndb, bid), sampled.shouldValidate(sampled.ndb, bid));
+			nSampled += sampled.shouldValidate(sampled.ndb, bid);
+		}
+		// Roughly 1 in 16 of the 1599 BIDs
+		ASSERT_GT(nSampled, 50U);
+		ASSERT_LT(nSampled, 150U);
+	}
+
+	TEST(BlockCacheTest, SharesDecodedBlocksAndEvictsPerShard)
+	{
+		const size_t blockBytes = makeDataBlock(0)->nBytesInMemory();
+		// Room for 2 blocks in each shard
+		BlockCache cache(blockBytes * 2 * BlockCache::NShards);
+		const std::shared_ptr<const DataBlock> first = makeDataBlock(1);
+		ASSERT_EQ(cache.find(BID(4)), nullptr);
+		ASSERT_EQ(cache.insert(BID(4), first), first);
+		ASSERT_EQ(cache.find(BID(4)), first);
+		// A second insert of the same BID hands back the block that is already cached.
+		ASSERT_EQ(cache.insert(BID(4), makeDataBlock(2)), first);
+		ASSERT_TRUE(std::ranges::equal(cache.find(BID(4))->data(), makeDataBlock(1)->data()));
+
+		// BIDs that are 4 * NShards apart land in the same shard.
+		const uint64_t stride = 4 * BlockCache::NShards;
+		cache.insert(BID(4 + stride), makeDataBlock(3));
+		ASSERT_EQ(cache.find(BID(4)), first); // 4 is now the most recently used
+		cache.insert(BID(4 + 2 * stride), makeDataBlock(4)); // evicts 4 + stride
+		ASSERT_EQ(cache.find(BID(4 + stride)), nullptr);
+		ASSERT_EQ(cache.find(BID(4)), first);
+		ASSERT_EQ(cache.nBlocks(), 2);
+
+		// Other shards are untouched by the eviction.
+		cache.insert(BID(8), makeDataBlock(5));
+		ASSERT_EQ(cache.nBlocks(), 3);
+		ASSERT_LE(cache.nBytes(), cache.byteBudget());
+	}
+	/**
+	 * A file with an NBT of two levels, a root page over two leaf pages, and a BBT of one leaf page.
+	 *  The nodes make up the root folder, a sub folder of it with messages, an FAI message and
+	 *  a sub folder of its own, and the message store and name to id map.
+	 *  Nodes have no data unless blocks are given for them, which are written after the pages.
+	*/
+	struct NDBFile
+	{
+		static constexpr uint64_t nbtRootIb = 0;
+		static constexpr uint64_t bbtRootIb = 3 * BTPage::size;
+		static constexpr uint64_t blocksIb = 4 * BTPage::size;
+		struct Block
+		{
+			uint64_t bid{};
+			std::vector<byte_t> data{};
+		};
+		/// The bidData and bidSub of a node that has data
+		struct NodeBlocks
+		{
+			uint64_t bidData{};
+			uint64_t bidSub{};
+		};
+
+		std::filesystem::path path{};
+		/// Where each block was written keyed by its BID
+		std::unordered_map<uint64_t, uint64_t> blockIbs{};
+		/// NID and nidParent of every node sorted by NID
+		std::vector<std::pair<uint32_t, uint32_t>> nodes{
+			{ 0x21, 0x0 }, { 0x61, 0x0 }, { 0x122, 0x122 }, { 0x12D, 0x0 }, { 0x12E, 0x0 }, { 0x12F, 0x0 },
+			{ 0x8022, 0x122 }, { 0x802D, 0x0 }, { 0x802E, 0x0 }, { 0x802F, 0x0 }, { 0x8042, 0x8022 },
+			{ 0x200024, 0x8022 }, { 0x200028, 0x8022 }, { 0x200044, 0x8022 }, { 0x200064, 0x122 }, { 0x200084, 0x8042 }
+		};
+
+		/**
+		 * @param nodeBlocks = the blocks of the nodes that have data keyed by NID.
+		 * @param blocks = sorted by BID. Each is written as a block of its own.
+		*/
+		explicit NDBFile(const std::string& name, const std::unordered_map<uint32_t, NodeBlocks>& nodeBlocks = {}, const std::vector<Block>& blocks = {})
+			: path(std::filesystem::temp_directory_path() / name)
+		{
+			const size_t half = nodes.size() / 2;
+			std::vector<std::vector<byte_t>> leaves(2);
+			for (size_t i = 0; i < nodes.size(); ++i)
+			{
+				const auto& [nid, parent] = nodes[i];
+				const auto refs = nodeBlocks.find(nid);
+				std::vector<byte_t>& leaf = leaves[i / half];
+				append(leaf, nid, 8);
+				append(leaf, refs != nodeBlocks.end() ? refs->second.bidData : 0x4 + 4 * i, 8);
+				append(leaf, refs != nodeBlocks.end() ? refs->second.bidSub : 0x0, 8);
+				append(leaf, parent, 4);
+				append(leaf, 0x0, 4);
+			}
+			std::vector<byte_t> root{};
+			for (size_t i = 0; i < leaves.size(); ++i)
+			{
+				append(root, nodes[i * half].first, 8);
+				append(root, 0x10 + 4 * i, 8);
+				append(root, (i + 1) * BTPage::size, 8);
+			}
+			std::vector<byte_t> bbt{};
+			append(bbt, 0x4, 8);
+			append(bbt, blocksIb, 8);
+			append(bbt, 0x0, 8);
+			std::vector<byte_t> blockBytes{};
+			for (const Block& block : blocks)
+			{
+				const uint64_t ib = blocksIb + blockBytes.size();
+				const std::vector<byte_t> bytes = makeBlockBytes(block.data, block.bid, ib);
+				blockBytes.insert(blockBytes.end(), bytes.begin(), bytes.end());
+				blockIbs[block.bid] = ib;
+				append(bbt, block.bid, 8);
+				append(bbt, ib, 8);
+				append(bbt, block.data.size(), 2);
+				append(bbt, 0x2, 2); // cRef
+				append(bbt, 0x0, 4);
+			}
+
+			std::ofstream out(path, std::ios::binary);
+			for (const auto& page : { 
+				makePage(root, 24, 1, PType::NBT, 0x0C, nbtRootIb), 
+				makePage(leaves[0], 32, 0, PType::NBT, 0x10, BTPage::size),
+				makePage(leaves[1], 32, 0, PType::NBT, 0x14, 2 * BTPage::size),
+				makePage(bbt, 24, 0, PType::BBT, 0x18, bbtRootIb) })
+			{
+				out.write(reinterpret_cast<const char*>(page.data()), page.size());
+			}
+			out.write(reinterpret_cast<const char*>(blockBytes.data()), blockBytes.size());
+		}
+		~NDBFile()
+		{
+			std::filesystem::remove(path);
+		}
+
+		[[nodiscard]] Header header() const
+		{
+			return Header(Root(BREF(0x0C, nbtRootIb), 4 * BTPage::size, BREF(0x18, bbtRootIb), 0), CryptMethod::NONE);
+		}
+
+		static void append(std::vector<byte_t>& bytes, uint64_t value, size_t size)
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				bytes.push_back(static_cast<byte_t>(value >> (8 * i)));
+			}
+		}
+
+		static std::vector<byte_t> makePage(const std::vector<byte_t>& entries, uint8_t entrySize, uint8_t cLevel, PType ptype, uint64_t bid, uint64_t ib)
+		{
+			std::vector<byte_t> page(entries);
+			page.resize(488, 0);
+			page.push_back(static_cast<byte_t>(entries.size() / entrySize));
+			page.push_back(static_cast<byte_t>(488 / entrySize));
+			page.push_back(entrySize);
+			page.push_back(cLevel);
+			append(page, 0x0, 4);
+			append(page, static_cast<uint8_t>(ptype), 1);
+			append(page, static_cast<uint8_t>(ptype), 1);
+			append(page, storyt::utils::ms::ComputeSig(ib, bid), 2);
+			append(page, storyt::utils::ms::ComputeCRC(0, page.data(), 496), 4);
+			append(page, bid, 8);
+			return page;
+		}
+	};
+
+	TEST(NDBTest, AllMatchesTheBTPageWalk)
+	{
+		const NDBFile file("storyt_ndb_all_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		const BTPage::GetPage_t getPage = [&source](const BREF& bref, int32_t parentCLevel) {
+			return std::make_shared<const BTPage>(BTPage::Init(source->read(bref.ib, BTPage::size).view(), bref, parentCLevel));
+		};
+		const BTPage rootNBT = BTPage::Init(source->read(NDBFile::nbtRootIb, BTPage::size).view(), BREF(0x0C, NDBFile::nbtRootIb));
+		ASSERT_EQ(rootNBT.cLevel, 1);
+
+		// all() builds its map from the pages when the index is not flattened and from the NBTIndex when it is.
+		NDB walked(*source, file.header());
+		NDB flattened(*source, file.header());
+		flattened.flattenIndex();
+		ASSERT_FALSE(walked.isIndexFlattened());
+		for (const auto& [nid, parent] : file.nodes)
+		{
+			const std::unordered_map<NIDType, NBTEntry> expected = rootNBT.all(NID(nid), getPage);
+			for (const NDB* ndb : { &walked, &flattened })
+			{
+				const std::unordered_map<NIDType, NBTEntry> entries = ndb->all(NID(nid));
+				ASSERT_EQ(entries.size(), expected.size());
+				for (const auto& [nidType, nbt] : expected)
+				{
+					ASSERT_TRUE(entries.contains(nidType));
+					ASSERT_EQ(entries.at(nidType).nid, nbt.nid);
+					ASSERT_EQ(entries.at(nidType).bidData, nbt.bidData);
+					ASSERT_EQ(entries.at(nidType).nidParent, nbt.nidParent);
+				}
+			}
+		}
+		// The 4 parts of a folder
+		ASSERT_EQ(walked.all(NID(0x8022)).size(), 4);
+		ASSERT_EQ(flattened.all(NID(0x802E)).at(NIDType::NORMAL_FOLDER).nid, NID(0x8022));
+		ASSERT_TRUE(walked.all(NID(0x9922)).empty());
+	}
+	TEST(NDBTest, ChildrenAndDescendantsFollowNidParent)
+	{
+		const NDBFile file("storyt_ndb_children_test.bin");
+		const std::unique_ptr<BlockSource> source = BlockSource::Init(file.path.string(), SourceType::PositionalRead);
+		const NDB ndb(*source, file.header());
+		auto raw = [](const std::vector<NID>& nids) {
+			std::vector<uint32_t> ret{};
+			for (const NID& nid : nids)
+			{
+				ret.push_back(nid.getNIDRaw());
+			}
+			return ret;
+		};
+
+		// Sorted by NID. The root folder is its own parent but is not listed as its own child.
+		ASSERT_EQ(raw(ndb.children(NID(0x122))), (std::vector<uint32_t>{ 0x8022, 0x200064 }));
+		ASSERT_EQ(raw(ndb.children(NID(0x8022))), (std::vector<uint32_t>{ 0x8042, 0x200024, 0x200028, 0x200044 }));
+		ASSERT_TRUE(ndb.children(NID(0x200024)).empty());
+
+		ASSERT_EQ(raw(ndb.children(NID(0x8022), NIDType::NORMAL_MESSAGE)), (std::vector<uint32_t>{ 0x200024, 0x200044 }));
+		ASSERT_EQ(raw(ndb.children(NID(0x8022), NIDType::NORMAL_FOLDER)), (std::vector<uint32_t>{ 0x8042 }));
+		ASSERT_EQ(ndb.nChildren(NID(0x8022), NIDType::NORMAL_MESSAGE), 2);
+		ASSERT_EQ(ndb.nChildren(NID(0x8022), NIDType::ASSOC_MESSAGE), 1);
+		ASSERT_EQ(ndb.nChildren(NID(0x122), NIDType::NORMAL_FOLDER), 1);
+
+		// The walk never returns the root itself.
+		std::vector<uint32_t> descendants = raw(ndb.descendants(NID(0x122)));
+		std::ranges::sort(descendants);
+		ASSERT_EQ(descendants, (std::vector<uint32_t>{ 0x8022, 0x8042, 0x200024, 0x200028, 0x200044, 0x200064, 0x200084 }));
+		std::vector<uint32_t> subtree = raw(ndb.descendants(NID(0x8022)));
+		std::ranges::sort(subtree);
+		ASSERT_EQ(subtree, (std::vector<uint32_t>{ 0x8042, 0x200024, 0x200028, 0x200044, 0x200084 }));
+	}
+};
@@ -11,6 +11,7 @@
 #include "util_tests.cpp"
 #include "ndb_tests.cpp"
 #include "ltp_tests.cpp"
+#include "messaging_tests.cpp"
 
 int main(int argc, char** argv)
 {   
@@ -8,6 +8,7 @@
 
 #include "types.h"
 #include "utils.h"
+#include "simd.h"
 
 
 namespace util_tests
@@ -98,6 +99,53 @@ namespace util_tests
 		}
 	}
 
+	TEST(UtilTests, LoadLEReadsUnalignedAndShortFields)
+	{
+		const std::vector<byte_t> A = { 0xFF, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+		const std::span<const byte_t> unaligned = std::span<const byte_t>(A).subspan(1);
+		ASSERT_EQ(loadLE<uint16_t>(unaligned.first(2)), 0x0201);
+		ASSERT_EQ(loadLE<uint32_t>(unaligned.first(4)), 0x04030201U);
+		ASSERT_EQ(loadLE<uint64_t>(unaligned), 0x0807060504030201ULL);
+		ASSERT_EQ(loadLE<uint64_t>(unaligned.first(3)), 0x030201ULL);
+		ASSERT_EQ(loadLE<int32_t>(std::span<const byte_t>(A).first(1)), 0xFF);
+		// A span longer than T only has its first sizeof(T) bytes read
+		ASSERT_EQ(loadLE<uint16_t>(unaligned), 0x0201);
+		ASSERT_EQ(loadLE<uint32_t>(std::span<const byte_t>(A)), 0x030201FFU);
+
+		ByteView view(A);
+		ASSERT_EQ(view.read<uint8_t>(1), 0xFF);
+		ASSERT_EQ(view.read<uint32_t>(2), 0x0201U);
+		ASSERT_EQ(view.read<uint64_t>(6), 0x080706050403ULL);
+	}
+
+	TEST(UtilTests, ByteViewThrowsOnTruncatedBytes)
+	{
+		// Also holds in release builds where STORYT_ASSERT only logs.
+		const std::vector<byte_t> A = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+		const std::span<const byte_t> truncated = std::span<const byte_t>(A).first(4);
+		{
+			ByteView view(truncated);
+			ASSERT_EQ(view.read<uint16_t>(2), 0x0201);
+			ASSERT_THROW(static_cast<void>(view.read<uint32_t>(4)), std::out_of_range);
+			ASSERT_THROW(static_cast<void>(view.readView(3)), std::out_of_range);
+			ASSERT_EQ(view.readView(2).size(), 2);
+			ASSERT_TRUE(view.readView(0).empty());
+			ASSERT_THROW(static_cast<void>(view.read<uint8_t>(1)), std::out_of_range);
+		}
+		{
+			ByteView view(truncated);
+			ASSERT_THROW(static_cast<void>(view.takeLast(5)), std::out_of_range);
+			ASSERT_EQ(view.takeLast(2), std::vector<byte_t>({ 0x03, 0x04 }));
+		}
+		{
+			// A skip past the end is caught by the next read
+			ByteView view(truncated);
+			view.skip(6);
+			ASSERT_THROW(static_cast<void>(view.readView(0)), std::out_of_range);
+			ASSERT_THROW(static_cast<void>(view.read<uint32_t>(1, 4)), std::out_of_range);
+		}
+	}
+
 	TEST(UtilTests, SliceTest)
 	{
 		{
@@ -121,5 +169,90 @@ namespace util_tests
 		ms::CryptPermute(A.data(), static_cast<int>(A.size()), ms::DECODE_DATA);
 		ASSERT_EQ(A, B);
 	}
+
+	TEST(UtilTests, SimdCryptPermuteMatchesScalar)
+	{
+		std::vector<byte_t> input(8192 + 77);
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<byte_t>((i * 131U) ^ (i >> 3U));
+		}
+		for (const storyt::simd::ISA isa : { storyt::simd::ISA::AVX2, storyt::simd::ISA::AVX512VBMI })
+		{
+			if (!storyt::simd::isSupported(isa))
+			{
+				continue;
+			}
+			// Odd sizes and unaligned starts exercise the scalar tail after the last full vector.
+			for (const size_t start : { 0U, 1U, 13U })
+			{
+				for (const size_t size : { 0U, 15U, 16U, 33U, 64U, 127U, 8192U })
+				{
+					for (const ms::BOOL encrypt : { ms::ENCODE_DATA, ms::DECODE_DATA })
+					{
+						std::vector<byte_t> expected(input.begin() + start, input.begin() + start + size);
+						std::vector<byte_t> actual(expected);
+						ms::CryptPermute(expected.data(), static_cast<int>(expected.size()), encrypt);
+						storyt::simd::CryptPermute(actual, encrypt == ms::ENCODE_DATA, isa);
+						ASSERT_EQ(actual, expected);
+					}
+				}
+			}
+		}
+	}
+
+	TEST(UtilTests, SimdCryptCyclicMatchesScalar)
+	{
+		std::vector<byte_t> input(8192 + 77);
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<byte_t>((i * 131U) ^ (i >> 3U));
+		}
+		for (const storyt::simd::ISA isa : { storyt::simd::ISA::AVX2, storyt::simd::ISA::AVX512VBMI })
+		{
+			if (!storyt::simd::isSupported(isa))
+			{
+				continue;
+			}
+			// The keys put the wrap of the low and high key bytes in the middle of a vector.
+			for (const uint32_t key : { 0x0U, 0x12345678U, 0x0000FFF0U, 0xABCD00E9U })
+			{
+				for (const size_t size : { 0U, 31U, 64U, 127U, 8192U + 77U })
+				{
+					std::vector<byte_t> expected(input.begin(), input.begin() + size);
+					std::vector<byte_t> actual(expected);
+					ms::CryptCyclic(expected.data(), static_cast<int>(expected.size()), key);
+					storyt::simd::CryptCyclic(actual, key, isa);
+					ASSERT_EQ(actual, expected);
+				}
+			}
+		}
+	}
+
+	TEST(UtilTests, SimdComputeCRCMatchesTable)
+	{
+		std::vector<byte_t> input(8192 + 77);
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			input[i] = static_cast<byte_t>((i * 131U) ^ (i >> 3U));
+		}
+		if (!storyt::simd::isSupported(storyt::simd::ISA::PCLMUL))
+		{
+			GTEST_SKIP() << "PCLMULQDQ is not supported by this CPU";
+		}
+		for (const uint32_t crc : { 0x0U, 0xFFFFFFFFU, 0x12345678U })
+		{
+			for (const size_t start : { 0U, 1U, 13U })
+			{
+				for (const size_t size : { 0U, 15U, 63U, 64U, 65U, 80U, 127U, 8176U, 8192U })
+				{
+					const byte_t* data = input.data() + start;
+					const uint32_t expected = ms::ComputeCRC(crc, data, static_cast<ms::UINT>(size));
+					const uint32_t actual = storyt::simd::ComputeCRC(crc, { data, size }, storyt::simd::ISA::PCLMUL);
+					ASSERT_EQ(actual, expected) << "crc " << crc << " start " << start << " size " << size;
+				}
+			}
+		}
+	}
 }; // end namespace util_tests
 